@@ -1,24 +1,77 @@
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
-int **a;
+#include<stdint.h>
+#include<stdatomic.h>
+#include<pthread.h>
+#include<sched.h>
+#include<unistd.h>
+//build: gcc -O2 -pthread project3.c
+uint64_t **a;//a[x] is the bitset of the fruits in conflict with x, bit k of the set stands for fruit k
+uint64_t *rows;//the bitsets of a, one after another in a single block
+int words;//number of 64-bit words in a bitset
 int *dp;
-int *prices;   
+int *prices;
 int n,m,x,y;
-//signal each fruit as a point,and our goal is to connect as many points into a path as possible 
+//signal each fruit as a point,and our goal is to connect as many points into a path as possible
 struct answer{
     int s;//length of path
     int price;//total cost
-    int list[101];//record the path
+    int *list;//record the path, list[1..s]
 };
 struct answer *ans;//the answer path
 struct answer *t;// temp path
-int Stack[102][102];//Stack[step][i] stores the candidate fruits for the [step]th layer
+//the reductions take some fruits into the answer and drop others, the rest falls apart into connected components;
+//the fruits are then renumbered so that component c is the fruits [lo, hi], and the components are searched apart
+struct component{
+    int lo, hi;
+    _Atomic uint64_t best_key;//the best answer of the component for the coloring search, see answer_key()
+    struct answer ans;//the best answer of the component, list[1..s] in input fruits and increasing order at the end
+};
+struct component *comps;
+int comp_count;
+int *perm;//perm[k] is the fruit of the input that the renumbered fruit k stands for
+int use_reduce = 1;//--no-reduce: no reductions and no components, the whole conflict graph is searched at once
+uint64_t *Stack;//Stack+step*words is the bitset of the candidate fruits for the [step]th layer
+long long nodes;//search nodes visited, printed to stderr with --nodes
+
+//--color: branch and bound with greedy coloring bounds (Tomita's MCQ/MCS, in the bitset form of BBMC)
+//a safe set is a clique of the complement graph, so a coloring of the complement bounds it: every color class
+//is a set of fruits that conflict pairwise, and a safe set takes at most one fruit of each class
+//--threads: the same search on several threads that steal parts of the search tree from each other
+int use_recolor;//--recolor: MCS re-coloring on top of the coloring, fewer nodes but more work per node
+
+//everything one thread of the coloring search needs for itself
+struct searcher{
+    uint64_t *Stack;//the candidate layers, like Stack of the dp search
+    int *order;//the colored candidates of all the layers on the current path, order[base..base+count)
+    int *colors;//the color of order[i]; order and colors grow together, so they are addressed by index
+    size_t arena_size, arena_used;
+    uint64_t *classes;//classes+k*words is color class k while a layer is colored
+    uint64_t *scratch;//two bitsets for the coloring
+    int *sorted;//a path in input fruits, sorted, to break ties between answers
+    struct answer t;//the current path
+    long long nodes;
+    int id;
+    int comp;//the component of the task it works on
+};
+
+static int count_bits(const uint64_t *set, int from)//number of fruits in the words [from, words) of a bitset
+{
+    int cnt = 0;
+    for(int w = from; w < words; w++)
+      cnt += __builtin_popcountll(set[w]);
+    return cnt;
+}
 
-void dfs(int num, int step, struct answer *t, struct answer *ans)
+void dfs(int step, int from, struct answer *t, struct answer *ans)
 {
-    //num is the number of candidate fruits for the current layer, step is the current depth
-    if(num == 0) 
+    //step is the current depth, the words of the candidate set before [from] are all zero
+    nodes++;
+    uint64_t *cand = Stack + (size_t)step*words;
+    uint64_t *next = cand + words;
+    int num = count_bits(cand, from);//the number of candidate fruits for the current layer
+    if(num == 0)
     {
       if(t->s>ans->s||(t->s == ans->s&&t->price<ans->price))//update ans if "t" is better than current ans
       {
@@ -28,91 +81,839 @@ void dfs(int num, int step, struct answer *t, struct answer *ans)
       }
       return;
     }
-    //traverse the candidate fruit of the current layer
-    for(int i = 0; i < num; i++)
-    {
-      int k = Stack[step][i];
-      //even if all the fruits numbered from i to num are selected, they cannot surpass the best answer
-      if(t->s+num-i<ans->s)
-        return;
-      //pruning 2: use dp value to prune more precisely
-      if(t->s + dp[k]<ans->s)
-        return;
-      // build the candidate set for the next layer: select the fruits that do not conflict with k from the remaining candidates
-      int cnt = 0;
-      for(int j=i+1;j<num; j++)
-      {
-        if(a[k][Stack[step][j]] == 0)
-          Stack[step+1][cnt++] = Stack[step][j];
-      }
-      
-      // choose fruit k into t->list
+    //traverse the candidate fruit of the current layer, in increasing order
+    for(int w = from; w < words; w++)
+      while(cand[w])
+      {
+        int k = w*64 + __builtin_ctzll(cand[w]);
+        //even if k and all the candidates after it are selected, they cannot surpass the best answer
+        if(t->s+num<ans->s)
+          return;
+        //pruning 2: use dp value to prune more precisely
+        if(t->s + dp[k]<ans->s)
+          return;
+        cand[w] &= cand[w]-1;//take k out, cand now holds the candidates after k
+        num--;
+        // build the candidate set for the next layer: the remaining candidates that do not conflict with k,
+        // one AND-NOT per 64 fruits
+        for(int j = w; j < words; j++)
+          next[j] = cand[j] & ~a[k][j];
+
+        // choose fruit k into t->list
+        t->list[++t->s] = k;
+        t->price += prices[k];
+
+        // recursively search the next layer
+        dfs(step+1, w, t, ans);
+
+        //backtrack
+        t->s--;
+        t->price -= prices[k];
+      }
+}
+static int first_bit(const uint64_t *set, int from)//the smallest fruit of a bitset, -1 if it is empty
+{
+    for(int w = from; w < words; w++)
+      if(set[w])
+        return w*64 + __builtin_ctzll(set[w]);
+    return -1;
+}
+
+static int class_misses(const uint64_t *cls, int v, int from, int *miss)//fruits of a class that do not conflict with v
+{
+    int cnt = 0;
+    for(int w = from; w < words && cnt < 2; w++)
+    {
+      uint64_t x = cls[w] & ~a[v][w];
+      if(x)
+      {
+        cnt += __builtin_popcountll(x);
+        *miss = w*64 + __builtin_ctzll(x);
+      }
+    }
+    return cnt;
+}
+
+//Re-NUMBER of MCS: v would get a color k >= kmin, which cannot prune it, so try to put it into a class below kmin,
+//directly if it conflicts with the whole class, or by moving the only fruit it does not conflict with to a higher class
+static int recolor(uint64_t *classes, int v, int kmin, int from)
+{
+    for(int k1 = 1; k1 < kmin; k1++)
+    {
+      uint64_t *c1 = classes + (size_t)k1*words;
+      int w;
+      int misses = class_misses(c1, v, from, &w);
+      if(misses == 0)
+      {
+        c1[v/64] |= 1ULL<<(v%64);
+        return 1;
+      }
+      if(misses > 1)
+        continue;
+      for(int k2 = k1+1; k2 < kmin; k2++)
+      {
+        uint64_t *c2 = classes + (size_t)k2*words;
+        int u;
+        if(class_misses(c2, w, from, &u) == 0)
+        {
+          c1[w/64] &= ~(1ULL<<(w%64));
+          c2[w/64] |= 1ULL<<(w%64);
+          c1[v/64] |= 1ULL<<(v%64);
+          return 1;
+        }
+      }
+    }
+    return 0;
+}
+
+//colors the candidates class by class, each class takes the smallest uncolored fruit and then the next ones that
+//conflict with everything in the class; only the fruits with a color >= kmin are written to out/col,
+//in nondecreasing color order, the others can never make the path longer than the best answer
+static int color_sort(struct searcher *sr, const uint64_t *cand, int from, int kmin, int *out, int *col)
+{
+    uint64_t *U = sr->scratch, *Q = sr->scratch + words;
+    int k = 0, cnt = 0;
+    memcpy(U + from, cand + from, sizeof(uint64_t)*(words - from));
+    for(int v; (v = first_bit(U, from)) >= 0; )
+    {
+      k++;
+      uint64_t *cls = sr->classes + (size_t)k*words;
+      if(k < kmin)
+        memset(cls + from, 0, sizeof(uint64_t)*(words - from));
+      memcpy(Q + from, U + from, sizeof(uint64_t)*(words - from));
+      for(int q = from; (v = first_bit(Q, q)) >= 0; q = v/64)
+      {
+        U[v/64] &= ~(1ULL<<(v%64));
+        Q[v/64] &= ~(1ULL<<(v%64));
+        if(k < kmin)
+          cls[v/64] |= 1ULL<<(v%64);
+        else if(use_recolor && recolor(sr->classes, v, kmin, from))
+          continue;
+        else
+        {
+          out[cnt] = v;
+          col[cnt++] = k;
+        }
+        for(int w = v/64; w < words; w++)
+          Q[w] &= a[v][w];
+      }
+    }
+    return cnt;
+}
+
+//the best answer of each component so far, shared by all the threads: the size and the price are packed into one
+//atomic word, so that a larger key is a better answer and every node can prune with it without a lock
+//the list of the answer is only written under best_lock
+pthread_mutex_t best_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t answer_key(int s, int price)
+{
+    return ((uint64_t)(uint32_t)s << 32) | (uint32_t)((int64_t)INT32_MAX - price);
+}
+
+static void load_best(struct component *c, int *s, int *price)
+{
+    uint64_t key = atomic_load_explicit(&c->best_key, memory_order_acquire);
+    *s = (int)(key >> 32);
+    *price = (int)((int64_t)INT32_MAX - (int64_t)(uint32_t)key);
+}
+
+static int by_value(const void *x, const void *y)
+{
+    return *(const int*)x - *(const int*)y;
+}
+
+static int lex_less(const int *x, const int *y, int s)//x[1..s] before y[1..s] in lexicographic order
+{
+    for(int i = 1; i <= s; i++)
+      if(x[i] != y[i])
+        return x[i] < y[i];
+    return 0;
+}
+
+//a complete path: it becomes the answer if it is larger, or as large and cheaper, or as large and as cheap but
+//smaller in lexicographic order of its sorted input fruits; the last rule makes the answer the same for every
+//number of threads, since no bound prunes a branch that can still tie with the answer
+static void offer_answer(struct searcher *sr)
+{
+    struct answer *t = &sr->t;
+    struct component *c = &comps[sr->comp];
+    uint64_t key = answer_key(t->s, t->price);
+    if(key < atomic_load_explicit(&c->best_key, memory_order_acquire))
+      return;
+    for(int i = 1; i <= t->s; i++)
+      sr->sorted[i] = perm[t->list[i]];
+    qsort(sr->sorted+1, t->s, sizeof(int), by_value);
+    pthread_mutex_lock(&best_lock);
+    uint64_t cur = atomic_load_explicit(&c->best_key, memory_order_relaxed);
+    if(key > cur || (key == cur && lex_less(sr->sorted, c->ans.list, t->s)))
+    {
+      c->ans.s = t->s;
+      c->ans.price = t->price;
+      memcpy(c->ans.list+1, sr->sorted+1, sizeof(int)*t->s);
+      atomic_store_explicit(&c->best_key, key, memory_order_release);
+    }
+    pthread_mutex_unlock(&best_lock);
+}
+
+//a part of the search tree a thread can hand to another: a path and the candidates that are still open after it
+struct task{
+    int comp;
+    int s, price;
+    int *list;//list[1..s]
+    uint64_t *cand;
+};
+
+//the tasks of one thread: the owner pushes and pops at the bottom, the others steal the oldest, largest parts at the top
+struct deque{
+    pthread_mutex_t lock;
+    struct task **items;
+    int head, tail, cap;
+    _Atomic int size;
+};
+
+struct deque *deques;
+int thread_count = 1;
+_Atomic int idle;//threads that are looking for work, a busy thread hands out work while this is not zero
+_Atomic long long outstanding;//tasks pushed but not finished yet, the search is over when it drops to zero
+
+static int push_task(struct deque *dq, struct task *task)
+{
+    pthread_mutex_lock(&dq->lock);
+    if(dq->tail == dq->cap)
+    {
+      int live = dq->tail - dq->head;
+      if(dq->head > 0)//slide the live tasks down before growing
+        memmove(dq->items, dq->items + dq->head, sizeof(struct task*)*live);
+      else
+      {
+        struct task **grown = (struct task**)realloc(dq->items, sizeof(struct task*)*dq->cap*2);
+        if(grown == NULL)
+        {
+          pthread_mutex_unlock(&dq->lock);
+          return 0;
+        }
+        dq->items = grown;
+        dq->cap *= 2;
+      }
+      dq->head = 0;
+      dq->tail = live;
+    }
+    dq->items[dq->tail++] = task;
+    atomic_fetch_add(&outstanding, 1);
+    atomic_fetch_add(&dq->size, 1);
+    pthread_mutex_unlock(&dq->lock);
+    return 1;
+}
+
+static struct task *take_task(struct deque *dq, int steal)
+{
+    struct task *task = NULL;
+    if(atomic_load_explicit(&dq->size, memory_order_relaxed) == 0)
+      return NULL;
+    pthread_mutex_lock(&dq->lock);
+    if(dq->tail > dq->head)
+    {
+      task = steal ? dq->items[dq->head++] : dq->items[--dq->tail];
+      atomic_fetch_sub(&dq->size, 1);
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return task;
+}
+
+static struct task *make_task(int comp, const struct answer *t, const uint64_t *cand)
+{
+    struct task *task = (struct task*)malloc(sizeof(struct task));
+    if(task == NULL)
+      return NULL;
+    task->list = (int*)malloc(sizeof(int)*(t->s+1));
+    task->cand = (uint64_t*)malloc(sizeof(uint64_t)*words);
+    if(task->list == NULL || task->cand == NULL)
+    {
+      free(task->list);
+      free(task->cand);
+      free(task);
+      return NULL;
+    }
+    task->comp = comp;
+    task->s = t->s;
+    task->price = t->price;
+    memcpy(task->list, t->list, sizeof(int)*(t->s+1));
+    memcpy(task->cand, cand, sizeof(uint64_t)*words);
+    return task;
+}
+
+void dfs_color(struct searcher *sr, int step, int from)
+{
+    struct answer *t = &sr->t;
+    uint64_t *cand = sr->Stack + (size_t)step*words;
+    uint64_t *next = cand + words;
+    sr->nodes++;
+    while(from < words && cand[from] == 0)
+      from++;
+    if(from == words)
+    {
+      offer_answer(sr);
+      return;
+    }
+    int best_s, best_price;
+    load_best(&comps[sr->comp], &best_s, &best_price);
+    size_t base = sr->arena_used;
+    size_t need = base + (size_t)count_bits(cand, from);
+    if(need > sr->arena_size)
+    {
+      while(sr->arena_size < need)
+        sr->arena_size *= 2;
+      sr->order = (int*)realloc(sr->order, sizeof(int)*sr->arena_size);
+      sr->colors = (int*)realloc(sr->colors, sizeof(int)*sr->arena_size);
+      if(sr->order == NULL || sr->colors == NULL)
+      {
+        fprintf(stderr,"Error: not enough memory for the colorings.\n");
+        exit(1);
+      }
+    }
+    int cnt = color_sort(sr, cand, from, best_s - t->s, sr->order + base, sr->colors + base);
+    sr->arena_used += cnt;
+    int minprice = 0, priced = 0;
+    //the candidates with the highest colors first, the color of a candidate bounds the fruits it can still add
+    for(int i = cnt-1; i >= 0; i--)
+    {
+      int k = sr->order[base+i];
+      int c = sr->colors[base+i];
+      load_best(&comps[sr->comp], &best_s, &best_price);
+      if(t->s + c < best_s)
+        break;
+      if(t->s + c == best_s)
+      {
+        //at best a tie in size: the missing fruits cost at least the cheapest candidate each
+        if(!priced)
+        {
+          for(int w = from; w < words; w++)
+            for(uint64_t x = cand[w]; x; x &= x-1)
+            {
+              int p = prices[w*64 + __builtin_ctzll(x)];
+              if(!priced || p < minprice)
+                minprice = p;
+              priced = 1;
+            }
+        }
+        if((long long)t->price + (long long)(best_s - t->s)*minprice > best_price)
+          break;
+      }
+      //another thread has run out of work: the rest of this layer becomes a task for it, but only
+      //after one candidate was expanded here, or a task could be handed on and on without progress
+      if(i > 0 && i < cnt-1 && atomic_load_explicit(&idle, memory_order_relaxed) > 0
+         && atomic_load_explicit(&deques[sr->id].size, memory_order_relaxed) == 0)
+      {
+        struct task *task = make_task(sr->comp, t, cand);
+        if(task != NULL && push_task(&deques[sr->id], task))
+          break;
+        if(task != NULL)
+        {
+          free(task->list);
+          free(task->cand);
+          free(task);
+        }
+      }
+      cand[k/64] &= ~(1ULL<<(k%64));//take k out, the rest of this layer goes without it
+      for(int j = from; j < words; j++)
+        next[j] = cand[j] & ~a[k][j];
       t->list[++t->s] = k;
       t->price += prices[k];
-      
-      // recursively search the next layer
-      dfs(cnt, step+1, t, ans);
-      
-      //backtrack
+      dfs_color(sr, step+1, from);
       t->s--;
       t->price -= prices[k];
     }
+    sr->arena_used = base;
+}
+
+static void *worker(void *arg)
+{
+    struct searcher *sr = (struct searcher*)arg;
+    int looking = 0;
+    while(1)
+    {
+      struct task *task = take_task(&deques[sr->id], 0);
+      for(int i = 1; task == NULL && i < thread_count; i++)
+        task = take_task(&deques[(sr->id + i) % thread_count], 1);
+      if(task == NULL)
+      {
+        if(atomic_load(&outstanding) == 0)
+          break;
+        if(!looking)
+        {
+          looking = 1;
+          atomic_fetch_add(&idle, 1);
+        }
+        sched_yield();
+        continue;
+      }
+      if(looking)
+      {
+        looking = 0;
+        atomic_fetch_sub(&idle, 1);
+      }
+      sr->comp = task->comp;
+      sr->t.s = task->s;
+      sr->t.price = task->price;
+      memcpy(sr->t.list, task->list, sizeof(int)*(task->s+1));
+      memcpy(sr->Stack + 2*(size_t)words, task->cand, sizeof(uint64_t)*words);
+      free(task->list);
+      free(task->cand);
+      free(task);
+      dfs_color(sr, 2, 0);
+      atomic_fetch_sub(&outstanding, 1);
+    }
+    if(looking)
+      atomic_fetch_sub(&idle, 1);
+    return NULL;
+}
+
+static int init_searcher(struct searcher *sr, int id)
+{
+    memset(sr, 0, sizeof(*sr));
+    sr->id = id;
+    sr->arena_size = (size_t)4*(m+1);//grown by dfs_color() when the layers of a path need more
+    sr->Stack = (uint64_t*)calloc((size_t)(m+3)*words,sizeof(uint64_t));
+    sr->order = (int*)malloc(sizeof(int)*sr->arena_size);
+    sr->colors = (int*)malloc(sizeof(int)*sr->arena_size);
+    sr->classes = (uint64_t*)malloc(sizeof(uint64_t)*(size_t)(m+2)*words);
+    sr->scratch = (uint64_t*)malloc(sizeof(uint64_t)*2*words);
+    sr->sorted = (int*)malloc(sizeof(int)*(m+1));
+    sr->t.list = (int*)malloc(sizeof(int)*(m+1));
+    return sr->Stack && sr->order && sr->colors && sr->classes && sr->scratch && sr->sorted && sr->t.list;
+}
+
+static void free_searcher(struct searcher *sr)
+{
+    free(sr->Stack);
+    free(sr->order);
+    free(sr->colors);
+    free(sr->classes);
+    free(sr->scratch);
+    free(sr->sorted);
+    free(sr->t.list);
+}
+
+//the reductions, on the conflict graph of the input; each one only drops fruits that some best answer does without
+//  a fruit without conflicts is in every largest safe set, so it is taken
+//  a fruit v with one conflict u and prices[v] <= prices[u] is taken and u dropped: an answer with u can swap it for v
+//  domination: if v conflicts with u, every other fruit v conflicts with conflicts with u as well and
+//  prices[v] <= prices[u], then u is dropped; the same swap keeps an answer safe, as large and no dearer
+//a fruit is checked again whenever it loses a conflict, so the rules run until none of them applies
+enum{KERNEL, TAKEN, DROPPED};
+struct reducer{
+    char *state;//KERNEL, TAKEN or DROPPED for each fruit
+    int *deg;//the conflicts of a fruit with the fruits still in the kernel
+    int *work, count;//the fruits to check again
+    char *queued;
+};
+
+static void requeue(struct reducer *rd, int v)
+{
+    if(!rd->queued[v])
+    {
+      rd->queued[v] = 1;
+      rd->work[rd->count++] = v;
+    }
+}
+
+static void drop_fruit(struct reducer *rd, int v)//v leaves the kernel, and with it its conflicts
+{
+    rd->state[v] = DROPPED;
+    for(int w = 0; w < words; w++)
+      for(uint64_t x = a[v][w]; x; x &= x-1)
+      {
+        int u = w*64 + __builtin_ctzll(x);
+        a[u][v/64] &= ~(1ULL<<(v%64));
+        rd->deg[u]--;
+        requeue(rd, u);
+      }
+    memset(a[v], 0, sizeof(uint64_t)*words);
+    rd->deg[v] = 0;
+}
+
+static int dominates(int v, int u)//v conflicts with u: does u conflict with all the other fruits v conflicts with
+{
+    for(int w = 0; w < words; w++)
+    {
+      uint64_t x = a[v][w] & ~a[u][w];
+      if(w == u/64)
+        x &= ~(1ULL<<(u%64));
+      if(x)
+        return 0;
+    }
+    return 1;
 }
-int main()
+
+static int reduce(char *state)
 {
+    struct reducer rd;
+    rd.state = state;
+    rd.deg = (int*)malloc(sizeof(int)*(m+1));
+    rd.work = (int*)malloc(sizeof(int)*(m+1));
+    rd.queued = (char*)calloc(m+1,sizeof(char));
+    rd.count = 0;
+    if(rd.deg == NULL || rd.work == NULL || rd.queued == NULL)
+      return 0;
+    for(int v = m; v >= 1; v--)//the fruits come off the stack from 1 up
+    {
+      rd.deg[v] = count_bits(a[v], 0);
+      requeue(&rd, v);
+    }
+    while(rd.count > 0)
+    {
+      int v = rd.work[--rd.count];
+      rd.queued[v] = 0;
+      if(state[v] != KERNEL)
+        continue;
+      if(rd.deg[v] == 0)
+      {
+        state[v] = TAKEN;
+        continue;
+      }
+      if(rd.deg[v] == 1)
+      {
+        int u = first_bit(a[v], 0);
+        if(prices[v] <= prices[u])
+          drop_fruit(&rd, u);//which queues v again, to be taken
+        continue;
+      }
+      //N[v] is in N[u] needs at least as many conflicts at u, most pairs fail in the first word that is compared
+      for(int w = 0; w < words; w++)
+        for(uint64_t x = a[v][w]; x; x &= x-1)
+        {
+          int u = w*64 + __builtin_ctzll(x);
+          if(rd.deg[u] >= rd.deg[v] && prices[v] <= prices[u] && dominates(v, u))
+            drop_fruit(&rd, u);
+        }
+    }
+    free(rd.deg);
+    free(rd.work);
+    free(rd.queued);
+    return 1;
+}
+
+static int by_component(const void *x, const void *y)//the component, then fewer conflicts first, then the smaller fruit
+{
+    const int *p = (const int*)x, *q = (const int*)y;
+    if(p[0] != q[0])
+      return p[0] - q[0];
+    return p[1] != q[1] ? p[1] - q[1] : p[2] - q[2];
+}
+
+//finds the components of the kernel breadth-first, numbered by their smallest fruit, and renumbers the kernel so that
+//every component is a range of fruits; a and prices are rebuilt for the kernel, m and words shrink to it
+//by_conflicts orders the fruits of a component for the colorings, in the initial order of MCQ: the fruits with the
+//fewest conflicts (the most neighbours in the complement) get the low colors, the others are branched on first;
+//the dp search keeps the input order
+static int split_components(const char *state, int by_conflicts)
+{
+    int (*key)[3] = (int (*)[3])malloc(sizeof(int[3])*(m+1));
+    int *comp = (int*)malloc(sizeof(int)*(m+1));
+    int *queue = (int*)malloc(sizeof(int)*(m+1));//the breadth-first queue, then renum[input fruit] = renumbered fruit
+    if(key == NULL || comp == NULL || queue == NULL)
+      return 0;
+    comp_count = 0;
+    for(int v = 1; v <= m; v++)
+      comp[v] = use_reduce ? -1 : 0;//--no-reduce: the whole graph is one component
+    if(!use_reduce)
+      comp_count = 1;
+    for(int v = 1; v <= m; v++)
+    {
+      if(state[v] != KERNEL || comp[v] >= 0)
+        continue;
+      int head = 0, tail = 0;
+      comp[v] = comp_count;
+      queue[tail++] = v;
+      while(head < tail)
+      {
+        int u = queue[head++];
+        for(int w = 0; w < words; w++)
+          for(uint64_t x = a[u][w]; x; x &= x-1)
+          {
+            int j = w*64 + __builtin_ctzll(x);
+            if(comp[j] < 0)
+            {
+              comp[j] = comp_count;
+              queue[tail++] = j;
+            }
+          }
+      }
+      comp_count++;
+    }
+    int kept = 0;
+    for(int v = 1; v <= m; v++)
+      if(state[v] == KERNEL)
+      {
+        key[kept][0] = comp[v];
+        key[kept][1] = by_conflicts ? count_bits(a[v], 0) : 0;
+        key[kept++][2] = v;
+      }
+    qsort(key, kept, sizeof(int[3]), by_component);
+
+    int words2 = kept/64+1;
+    uint64_t *rows2 = (uint64_t*)calloc((size_t)(kept+1)*words2,sizeof(uint64_t));
+    int *prices2 = (int*)calloc(kept+1,sizeof(int));
+    comps = (struct component*)calloc(comp_count+1,sizeof(struct component));
+    perm = (int*)malloc(sizeof(int)*(kept+1));
+    if(rows2 == NULL || prices2 == NULL || comps == NULL || perm == NULL)
+      return 0;
+    int *renum = queue;
+    for(int i = 1; i <= kept; i++)
+    {
+      struct component *c = &comps[key[i-1][0]];
+      perm[i] = key[i-1][2];
+      renum[perm[i]] = i;
+      if(c->lo == 0)
+        c->lo = i;
+      c->hi = i;
+    }
+    for(int c = 0; c < comp_count; c++)
+    {
+      atomic_init(&comps[c].best_key, 0);
+      comps[c].ans.list = (int*)malloc(sizeof(int)*(comps[c].hi - comps[c].lo + 2));
+      if(comps[c].ans.list == NULL)
+        return 0;
+    }
+    for(int i = 1; i <= kept; i++)
+    {
+      uint64_t *row = rows2 + (size_t)i*words2;
+      for(int w = 0; w < words; w++)
+        for(uint64_t x = a[perm[i]][w]; x; x &= x-1)
+        {
+          int j = renum[w*64 + __builtin_ctzll(x)];
+          row[j/64] |= 1ULL<<(j%64);
+        }
+      prices2[i] = prices[perm[i]];
+    }
+    free(rows);
+    free(prices);
+    rows = rows2;
+    prices = prices2;
+    m = kept;
+    words = words2;
+    for(int i = 0; i <= m; i++)
+      a[i] = rows + (size_t)i*words;
+    free(key);
+    free(comp);
+    free(queue);
+    return 1;
+}
+
+//the reductions and the split, the fruits taken by the reductions go straight into ans
+static int prepare(int by_conflicts)
+{
+    char *state = (char*)calloc(m+1,sizeof(char));
+    if(state == NULL || (use_reduce && !reduce(state)))
+      return 0;
+    for(int v = 1; v <= m; v++)
+      if(state[v] == TAKEN)
+      {
+        ans->list[++ans->s] = v;
+        ans->price += prices[v];
+      }
+    int ok = split_components(state, by_conflicts);
+    free(state);
+    return ok;
+}
+
+//no fruit of a component conflicts with another component or a taken fruit, so the largest safe set is the union of
+//the largest ones of the components, and it is the cheapest if each of them is
+static void combine(void)
+{
+    for(int c = 0; c < comp_count; c++)
+    {
+      memcpy(ans->list + ans->s + 1, comps[c].ans.list + 1, sizeof(int)*comps[c].ans.s);
+      ans->s += comps[c].ans.s;
+      ans->price += comps[c].ans.price;
+      free(comps[c].ans.list);
+    }
+    qsort(ans->list+1, ans->s, sizeof(int), by_value);
+    free(comps);
+    free(perm);
+}
+
+//every component is a task of its own, the threads split them, and the large ones among them, as they run out of work
+static int solve_color(void)
+{
+    struct searcher *searchers = (struct searcher*)calloc(thread_count,sizeof(struct searcher));
+    pthread_t *threads = (pthread_t*)malloc(sizeof(pthread_t)*thread_count);
+    deques = (struct deque*)calloc(thread_count,sizeof(struct deque));
+    if(searchers==NULL||threads==NULL||deques==NULL)
+      return 0;
+    for(int i = 0; i < thread_count; i++)
+    {
+      if(!init_searcher(&searchers[i], i))
+        return 0;
+      pthread_mutex_init(&deques[i].lock, NULL);
+      deques[i].cap = 64;
+      deques[i].items = (struct task**)malloc(sizeof(struct task*)*deques[i].cap);
+      if(deques[i].items == NULL)
+        return 0;
+    }
+
+    uint64_t *first = searchers[0].Stack + 2*(size_t)words;
+    for(int c = 0; c < comp_count; c++)
+    {
+      memset(first, 0, sizeof(uint64_t)*words);
+      for(int j = comps[c].lo; j <= comps[c].hi; j++)
+        first[j/64] |= 1ULL<<(j%64);
+      struct task *root = make_task(c, &searchers[0].t, first);
+      if(root == NULL || !push_task(&deques[c % thread_count], root))
+        return 0;
+    }
+    for(int i = 1; i < thread_count; i++)
+      if(pthread_create(&threads[i], NULL, worker, &searchers[i]) != 0)
+        return 0;
+    worker(&searchers[0]);
+    for(int i = 1; i < thread_count; i++)
+      pthread_join(threads[i], NULL);
+
+    for(int i = 0; i < thread_count; i++)
+    {
+      nodes += searchers[i].nodes;
+      free_searcher(&searchers[i]);
+      free(deques[i].items);
+      pthread_mutex_destroy(&deques[i].lock);
+    }
+    free(searchers);
+    free(threads);
+    free(deques);
+    return 1;
+}
+
+//the Russian-doll search, one component after another: dp[i] is the largest safe set among the fruits i..hi of
+//the component of i, found from back to front
+static void solve_dp(void)
+{
+    for(int c = 0; c < comp_count; c++)
+    {
+      struct answer *best = &comps[c].ans;
+      int lo = comps[c].lo, hi = comps[c].hi;
+      //from back to front to calculate dp values
+      for(int i=hi;i>=lo;i--)
+      {
+        // build the first layer candidate set: the fruits of the component with ID greater than i that do not conflict with i
+        uint64_t *first = Stack + 2*(size_t)words;
+        int from = (i+1)/64;
+        memset(first, 0, sizeof(uint64_t)*words);
+        for(int j=i+1;j<=hi;j++)
+          first[j/64]|=1ULL<<(j%64);
+        for(int w=from;w<words;w++)
+          first[w]&=~a[i][w];
+
+        // choose fruit i as the starting point
+        t->list[++t->s] = i;
+        t->price+=prices[i];
+        dfs(2,from,t,best);
+        // backtrack
+        t->s--;
+        t->price-=prices[i];
+        dp[i] = best->s;//record the max length of path after i-th point,in order for pruning
+      }
+      for(int i = 1; i <= best->s; i++)
+        best->list[i] = perm[best->list[i]];//the input order is kept, so the list stays increasing
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int use_color = 0, show_nodes = 0;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i],"--color")==0)
+            use_color = 1;//coloring bounds instead of the dp bounds
+        else if(strcmp(argv[i],"--recolor")==0)
+            use_color = use_recolor = 1;
+        else if(strcmp(argv[i],"--threads")==0&&i+1<argc)
+        {
+            thread_count = atoi(argv[++i]);//0 takes every core
+            if(thread_count <= 0)
+                thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+            if(thread_count <= 0)
+                thread_count = 1;
+            use_color = 1;
+        }
+        else if(strcmp(argv[i],"--no-reduce")==0)
+            use_reduce = 0;
+        else if(strcmp(argv[i],"--nodes")==0)
+            show_nodes = 1;//print the size of the kernel and the number of search nodes to stderr
+        else
+        {
+            fprintf(stderr,"Usage: %s [--color | --recolor] [--threads k] [--no-reduce] [--nodes] < input\n",argv[0]);
+            return 1;
+        }
+    }
   //initialization
-    t=(struct answer*)malloc(sizeof(struct answer));
-    ans=(struct answer*)malloc(sizeof(struct answer));
-    scanf("%d%d",&n,&m);
-    a = (int**)malloc(sizeof(int*)*(m+1));
+    if(scanf("%d%d",&n,&m)!=2||n<0||m<1)
+    {
+        fprintf(stderr,"Error: the input must start with the number of conflicts and the number of fruits.\n");
+        return 1;
+    }
+    words = m/64+1;//fruit k is bit k%64 of word k/64, bit 0 is never used
+    //everything is sized by m: the bitsets take m*m/8 bytes, the layers of the search as much again
+    t=(struct answer*)calloc(1,sizeof(struct answer));
+    ans=(struct answer*)calloc(1,sizeof(struct answer));
+    a = (uint64_t**)malloc(sizeof(uint64_t*)*(m+1));
+    rows = (uint64_t*)calloc((size_t)(m+1)*words,sizeof(uint64_t));
     dp= (int *)malloc(sizeof(int)*(m+1));
-    for(int i=0;i<=m;i++)
+    //a path holds at most m fruits, so the search never goes deeper than layer m+2
+    Stack=(uint64_t*)calloc((size_t)(m+3)*words,sizeof(uint64_t));
+    prices=(int*)calloc(m+1,sizeof(int));
+    if(t==NULL||ans==NULL||a==NULL||rows==NULL||dp==NULL||Stack==NULL||prices==NULL
+       ||(t->list=(int*)malloc(sizeof(int)*(m+1)))==NULL||(ans->list=(int*)malloc(sizeof(int)*(m+1)))==NULL)
     {
-        a[i]=(int*)malloc(sizeof(int)*(m+1));
+        fprintf(stderr,"Error: not enough memory for %d fruits.\n",m);
+        return 1;
     }
     for(int i=0;i<=m;i++)
-      for(int j=0;j<=m;j++)
-        a[i][j]=0;
-    prices=(int*)malloc(sizeof(int)*(m+1));
-    memset(t, 0, sizeof(struct answer));
-    memset(ans, 0, sizeof(struct answer));
+        a[i]=rows+(size_t)i*words;
     for(int i=1;i<=n;i++)
     {
-        scanf("%d%d",&x,&y);
-        a[x][y]=a[y][x]=1;//x and y are in contradiction
+        if(scanf("%d%d",&x,&y)!=2||x<1||x>m||y<1||y>m)
+        {
+            fprintf(stderr,"Error: conflict %d is not a pair of fruits between 1 and %d.\n",i,m);
+            return 1;
+        }
+        a[x][y/64]|=1ULL<<(y%64);//x and y are in contradiction
+        a[y][x/64]|=1ULL<<(x%64);
     }
     for(int i=1;i<=m;i++)
     {
-        scanf("%d%d",&x,&y);
+        if(scanf("%d%d",&x,&y)!=2||x<1||x>m)
+        {
+            fprintf(stderr,"Error: price %d does not belong to a fruit between 1 and %d.\n",i,m);
+            return 1;
+        }
         prices[x]=y;
     }
-    //from back to front to calculate dp values
-    for(int i=m;i>=1;i--)
-      {
-      // build the first layer candidate set: all fruits with ID greater than i
-      int s=0;
-      for(int j=i+1;j<=m;j++)
-      {
-      //  printf("a[%d][%d]=%d\n",i,j,a[i][j]);
-        if(a[i][j]==0)
-          Stack[2][s++]=j;
-      }
-      
-      // choose fruit i as the starting point
-      t->list[++t->s] = i;
-      t->price+=prices[i];
-      dfs(s,2,t,ans);
-      // backtrack
-      t->s--;
-      t->price-=prices[i];
-      dp[i] = ans->s;//record the max length of path after i-th point,in order for pruning
+    int fruits = m;
+    if(!prepare(use_color)||(use_color&&!solve_color()))
+    {
+        fprintf(stderr,"Error: not enough memory for %d fruits.\n",fruits);
+        return 1;
     }
+    if(show_nodes)
+      fprintf(stderr,"kernel: %d of %d fruits in %d components\n",m,fruits,comp_count);
+    if(!use_color)
+      solve_dp();
+    combine();
     printf("%d\n",ans->s);
     printf("%03d",ans->list[1]);
     for(int i=2;i<=ans->s;i++)
       printf(" %03d",ans->list[i]);
     printf("\n%d",ans->price);
+    if(show_nodes)
+      fprintf(stderr,"search nodes: %lld\n",nodes);
+    free(rows);
+    free(a);
+    free(Stack);
+    free(dp);
+    free(prices);
+    free(t->list);
+    free(ans->list);
     free(t);
     free(ans);
     return 0;
-}
\ No newline at end of file
+}
@@ -1,33 +1,75 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>    
-int conflicts[100][2];
-int prices[101];
+#include <stdint.h>
+#include <time.h>
+int (*conflicts)[2];//conflicts[i] is the i-th pair, in the order it was drawn
+int *prices;
+uint64_t *seen;//open-addressing hash set of the pairs drawn so far, 0 marks an empty slot
+size_t seen_mask;//the set has seen_mask+1 slots, a power of two
 int random_int(int min, int max) {
-    return min + rand() % (max - min + 1);
+    //two calls of rand() so that M can be larger than RAND_MAX on platforms where it is only 32767
+    unsigned long r = ((unsigned long)rand() << 15) ^ (unsigned long)rand();
+    return min + (int)(r % (unsigned long)(max - min + 1));
 }
-int conflict_exists(int conflicts[][2], int count, int a, int b) 
+static uint64_t pair_key(int a, int b)//the same key for (a,b) and (b,a), never 0 since fruits start at 1
 {
-    for (int i=0;i<count;i++)
-        if((conflicts[i][0]==a && conflicts[i][1]==b) ||
-            (conflicts[i][0]==b && conflicts[i][1]==a))
+    uint64_t lo = a < b ? a : b, hi = a < b ? b : a;
+    return (hi << 32) | lo;
+}
+static size_t pair_slot(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;//the 64-bit finalizer of MurmurHash3
+    key ^= key >> 33;
+    return (size_t)key & seen_mask;
+}
+int conflict_exists(int a, int b)//O(1) on average instead of a scan over all the pairs
+{
+    uint64_t key = pair_key(a, b);
+    for (size_t i = pair_slot(key); seen[i] != 0; i = (i + 1) & seen_mask)
+        if (seen[i] == key)
             return 1;
     return 0;
 }
+static void add_conflict(int a, int b)
+{
+    uint64_t key = pair_key(a, b);
+    size_t i = pair_slot(key);
+    while (seen[i] != 0)
+        i = (i + 1) & seen_mask;
+    seen[i] = key;
+}
 
-int main() 
+int main()
 {
     int N,M;
     srand(time(NULL));
-    scanf("%d %d", &N, &M);
+    if (scanf("%d %d", &N, &M) != 2 || N < 0 || M < 1 || (long long)N > (long long)M * (M - 1) / 2)
+    {
+        fprintf(stderr, "Error: N must be between 0 and M*(M-1)/2 for M fruits.\n");
+        return 1;
+    }
+    size_t slots = 2;
+    while (slots < 2 * (size_t)N)//at most half full, so the probes stay short
+        slots <<= 1;
+    seen_mask = slots - 1;
+    seen = (uint64_t*)calloc(slots, sizeof(uint64_t));
+    conflicts = (int (*)[2])malloc(sizeof(int[2]) * (N > 0 ? N : 1));
+    prices = (int*)malloc(sizeof(int) * (M + 1));
+    if (seen == NULL || conflicts == NULL || prices == NULL)
+    {
+        fprintf(stderr, "Error: not enough memory for %d conflicts.\n", N);
+        return 1;
+    }
     int conflict_count=0;
-    while(conflict_count<N) 
+    while(conflict_count<N)
     {
         int a=random_int(1,M);
         int b=random_int(1,M);
-        if(a!=b&&!conflict_exists(conflicts,conflict_count,a,b)) 
+        if(a!=b&&!conflict_exists(a,b))
         {
+            add_conflict(a,b);
             conflicts[conflict_count][0]=a;
             conflicts[conflict_count][1]=b;
             conflict_count++;
@@ -40,5 +82,8 @@ int main()
         printf("%03d %03d\n",conflicts[i][0],conflicts[i][1]);
     for (int i=1;i<=M;i++)
         printf("%03d %d\n",i,prices[i]);
+    free(seen);
+    free(conflicts);
+    free(prices);
     return 0;
-}
\ No newline at end of file
+}
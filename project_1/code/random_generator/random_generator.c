@@ -2,28 +2,119 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <stdint.h>
+#include "dataset.h"
+#include "keyorder.h"
 
-// Helper function to generate a shuffled array
-void shuffle(int *array, int n) {
-    if (n > 1) {
-        int i;
-        for (i = 0; i < n - 1; i++) {
-            int j = i + rand() / (RAND_MAX / (n - i) + 1);
-            int t = array[j];
-            array[j] = array[i];
-            array[i] = t;
+#define WRITE_CHUNK (1 << 16)   // values encoded and written per fwrite() of the binary format
+
+// Writes the data set in the binary format of dataset.h, WRITE_CHUNK values per fwrite()
+int write_binary(const char *path, const int *data, int n, const char *order_type, uint64_t seed, int value_bytes) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        perror("Failed to open output file");
+        return 0;
+    }
+    DatasetInfo info;
+    memset(&info, 0, sizeof(info));
+    info.valueBytes = value_bytes;
+    info.count = (uint64_t)n;
+    info.seed = seed;
+    memcpy(info.order, order_type, strlen(order_type));//main() keeps it within DATASET_ORDER_BYTES
+
+    unsigned char *chunk = (unsigned char *)malloc((size_t)WRITE_CHUNK * value_bytes);
+    int ok = chunk != NULL && writeDatasetHeader(file, &info);
+    for (int start = 0; ok && start < n; start += WRITE_CHUNK) {
+        int count = n - start < WRITE_CHUNK ? n - start : WRITE_CHUNK;
+        for (int i = 0; i < count; i++) {
+            uint64_t value = (uint64_t)(int64_t)data[start + i];
+            for (int b = 0; b < value_bytes; b++) {
+                chunk[(size_t)i * value_bytes + b] = (unsigned char)(value >> (8 * b));  // little-endian on every host
+            }
         }
+        ok = fwrite(chunk, value_bytes, count, file) == (size_t)count;
+    }
+    free(chunk);
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) perror("Failed to write output file");
+    return ok;
+}
+
+// Writes the text format: the count on the first line, then the values
+int write_text(FILE *file, const int *data, int n) {
+    fprintf(file, "%d\n", n);
+    for (int i = 0; i < n; i++) {
+        fprintf(file, "%d ", data[i]);
     }
+    fprintf(file, "\n");
+    return !ferror(file);
+}
+
+// Writes a delete or lookup stream to path, in the same format as the data set
+int write_stream(const char *path, const int *data, int n, int binary, const char *order_type, uint64_t seed, int value_bytes) {
+    if (binary) {
+        return write_binary(path, data, n, order_type, seed, value_bytes);
+    }
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror("Failed to open output file");
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    int ok = write_text(file, data, n);
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) perror("Failed to write output file");
+    return ok;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <N> <order_type>\n", argv[0]);
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <N> <order_type> [options]\n", argv[0]);
         fprintf(stderr, "  <N>: Number of integers to generate\n");
-        fprintf(stderr, "  <order_type>: 'inc' for increasing, 'dec' for decreasing, 'rand' for random\n");
+        fprintf(stderr, "  <order_type>: 'inc' for increasing, 'dec' for decreasing, 'rand' for random,\n");
+        fprintf(stderr, "                'nearly[:p]' sorted with a fraction p of the keys out of place (default 0.05),\n");
+        fprintf(stderr, "                'zipf[:s]' popular keys first, popularity ~ 1/rank^s (default 0.99),\n");
+        fprintf(stderr, "                'sawtooth[:k]' k ascending runs over the whole range (default 8),\n");
+        fprintf(stderr, "                'clustered[:size]' runs of consecutive keys in random order (default sqrt(N) keys)\n");
+        fprintf(stderr, "  --binary <file>: write the binary format tree_analyzer maps (test_data/input_<N>_<order>.bin)\n");
+        fprintf(stderr, "                   instead of the text format on stdout\n");
+        fprintf(stderr, "  --int64: store the values as int64 in the binary format (default: int32)\n");
+        fprintf(stderr, "  --seed <s>: seed of the generators (default: the current time)\n");
+        fprintf(stderr, "  --deletes <file>: also write the order the keys are deleted in (test_data/delete_<N>_<order>.txt)\n");
+        fprintf(stderr, "  --lookups <file>: also write keys to look up, Zipf-skewed for zipf (test_data/lookup_<N>_<order>.txt)\n");
+        fprintf(stderr, "  --lookup-count <m>: number of lookup keys (default: N)\n");
         return 1;
     }
 
+    const char *binary_path = NULL;
+    const char *deletes_path = NULL;
+    const char *lookups_path = NULL;
+    int lookup_count = 0;
+    int value_bytes = 4;
+    uint64_t seed = (uint64_t)time(NULL);
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0 && i + 1 < argc) {
+            binary_path = argv[++i];
+        } else if (strcmp(argv[i], "--int64") == 0) {
+            value_bytes = 8;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--deletes") == 0 && i + 1 < argc) {
+            deletes_path = argv[++i];
+        } else if (strcmp(argv[i], "--lookups") == 0 && i + 1 < argc) {
+            lookups_path = argv[++i];
+        } else if (strcmp(argv[i], "--lookup-count") == 0 && i + 1 < argc) {
+            lookup_count = atoi(argv[++i]);
+            if (lookup_count <= 0) {
+                fprintf(stderr, "--lookup-count needs a positive number.\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+            return 1;
+        }
+    }
+
     int N = atoi(argv[1]);
     const char *order_type = argv[2];
 
@@ -32,43 +123,48 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    int *data = (int *)malloc(N * sizeof(int));
-    if (data == NULL) {
-        perror("Failed to allocate memory");
+    KeyOrder order;
+    if (!parseKeyOrder(order_type, &order)) {
+        fprintf(stderr, "Invalid order_type. Use 'inc', 'dec', 'rand', 'nearly[:p]', 'zipf[:s]', 'sawtooth[:k]' or 'clustered[:size]'.\n");
         return 1;
     }
-
-    // Populate data with numbers 1 to N
-    for (int i = 0; i < N; i++) {
-        data[i] = i + 1;
+    if (binary_path && strlen(order_type) > DATASET_ORDER_BYTES) {
+        fprintf(stderr, "The binary format records order types of at most %d characters.\n", DATASET_ORDER_BYTES);
+        return 1;
     }
+    if (lookup_count == 0) lookup_count = N;
 
-    // Reorder based on the specified type
-    if (strcmp(order_type, "inc") == 0) {
-        // Already in increasing order, no change needed
-    } else if (strcmp(order_type, "dec") == 0) {
-        // Reverse for decreasing order
-        for (int i = 0; i < N / 2; i++) {
-            int temp = data[i];
-            data[i] = data[N - 1 - i];
-            data[N - 1 - i] = temp;
-        }
-    } else if (strcmp(order_type, "rand") == 0) {
-        // Shuffle for random order
-        srand((unsigned int)time(NULL));
-        shuffle(data, N);
-    } else {
-        fprintf(stderr, "Invalid order_type. Use 'inc', 'dec', or 'rand'.\n");
+    int *data = (int *)malloc((size_t)N * sizeof(int));
+    int *deletes = deletes_path ? (int *)malloc((size_t)N * sizeof(int)) : NULL;
+    int *lookups = lookups_path ? (int *)malloc((size_t)lookup_count * sizeof(int)) : NULL;
+    if (data == NULL || (deletes_path && deletes == NULL) || (lookups_path && lookups == NULL)
+        || !generateKeyStreams(&order, N, seed, data, deletes, lookups, lookup_count)) {
+        perror("Failed to allocate memory");
         free(data);
+        free(deletes);
+        free(lookups);
         return 1;
     }
 
-    // Output the data in the required format
-    printf("%d\n", N); // First line is the number of elements
-    for (int i = 0; i < N; i++) {
-        printf("%d ", data[i]);
+    int binary = binary_path != NULL;
+    int ok = 1;
+    if (deletes_path) {
+        ok = write_stream(deletes_path, deletes, N, binary, order_type, seed, value_bytes);
+    }
+    if (ok && lookups_path) {
+        ok = write_stream(lookups_path, lookups, lookup_count, binary, order_type, seed, value_bytes);
     }
-    printf("\n");
+    free(deletes);
+    free(lookups);
+    if (!ok || binary) {
+        ok = ok && write_binary(binary_path, data, N, order_type, seed, value_bytes);
+        free(data);
+        return ok ? 0 : 1;
+    }
+
+    // Output the data in the required format, through a large stdout buffer
+    setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+    write_text(stdout, data, N); // First line is the number of elements
 
     free(data);
     return 0;
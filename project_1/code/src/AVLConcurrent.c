@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "AVLConcurrent.h"
+#include "AVLSet.h"
+
+void cavlInit(ConcurrentAVL* tree, AVLNode* root)
+{
+    atomic_init(&tree->root, root);
+    atomic_init(&tree->epoch, 0);
+    pthread_mutex_init(&tree->writeLock, NULL);
+    for (int i = 0; i < 3; i ++) {
+        tree->retired[i].nodes = NULL;
+        tree->retired[i].count = 0;
+        tree->retired[i].capacity = 0;
+    }
+    tree->replaced.nodes = NULL;
+    tree->replaced.count = 0;
+    tree->replaced.capacity = 0;
+    for (int i = 0; i < CAVL_MAX_READERS; i ++) {
+        atomic_init(&tree->readers[i].epoch, CAVL_QUIESCENT);
+    }
+}
+
+static void freeRetired(AVLNodeList* list)
+{
+    for (int i = 0; i < list->count; i ++) {
+        freeAVLNode(list->nodes[i]);
+    }
+    list->count = 0;
+}
+
+void cavlDestroy(ConcurrentAVL* tree)
+{
+    for (int i = 0; i < 3; i ++) {
+        freeRetired(&tree->retired[i]);
+        free(tree->retired[i].nodes);
+    }
+    free(tree->replaced.nodes);
+    destroyAVL(atomic_load(&tree->root));
+    atomic_store(&tree->root, NULL);
+    pthread_mutex_destroy(&tree->writeLock);
+}
+
+int cavlContains(ConcurrentAVL* tree, int reader, int value)
+{
+    CAVLReaderSlot* slot = &tree->readers[reader];
+    atomic_store(&slot->epoch, atomic_load(&tree->epoch));
+    //announce the epoch before the root is read, both sequentially consistent: either the writer sees
+    //the announcement, or this reader sees a root published after the nodes the writer is about to free were unlinked
+    AVLNode* node = atomic_load(&tree->root);
+    while (node != NULL && node->val != value) {
+        node = value < node->val ? node->left : node->right;
+    }
+    int found = node != NULL;
+    atomic_store_explicit(&slot->epoch, CAVL_QUIESCENT, memory_order_release);
+    return found;
+}
+
+static void tryAdvance(ConcurrentAVL* tree)
+{
+    //the epoch moves on once every reader inside the tree has announced the current one
+    unsigned long epoch = atomic_load(&tree->epoch);
+    for (int i = 0; i < CAVL_MAX_READERS; i ++) {
+        unsigned long seen = atomic_load(&tree->readers[i].epoch);
+        if (seen != CAVL_QUIESCENT && seen != epoch) {
+            return;
+        }
+    }
+    atomic_store(&tree->epoch, epoch + 1);
+    freeRetired(&tree->retired[(epoch + 2) % 3]);
+    //these nodes were retired in epoch - 1, and every reader that could see them has left by now
+}
+
+static void publish(ConcurrentAVL* tree, AVLNode* root)
+{
+    atomic_store(&tree->root, root);
+    //the new nodes were written before the store, so a reader that sees the root sees them as well
+    AVLNodeList* limbo = &tree->retired[atomic_load(&tree->epoch) % 3];
+    for (int i = 0; i < tree->replaced.count; i ++) {
+        appendAVLNode(limbo, tree->replaced.nodes[i]);
+    }
+    tree->replaced.count = 0;
+    tryAdvance(tree);
+}
+
+void cavlInsert(ConcurrentAVL* tree, int value)
+{
+    pthread_mutex_lock(&tree->writeLock);
+    AVLNode* root = atomic_load_explicit(&tree->root, memory_order_relaxed);
+    AVLNode* newRoot = insertAVLCopy(root, value, &tree->replaced);
+    if (newRoot != root) {
+        publish(tree, newRoot);
+    }
+    pthread_mutex_unlock(&tree->writeLock);
+}
+
+void cavlDelete(ConcurrentAVL* tree, int value)
+{
+    pthread_mutex_lock(&tree->writeLock);
+    AVLNode* root = atomic_load_explicit(&tree->root, memory_order_relaxed);
+    AVLNode* newRoot = deleteAVLCopy(root, value, &tree->replaced);
+    if (tree->replaced.count > 0) {
+        publish(tree, newRoot);
+    }
+    pthread_mutex_unlock(&tree->writeLock);
+}
@@ -0,0 +1,41 @@
+#ifndef AVL_CONCURRENT_HEADER
+#define AVL_CONCURRENT_HEADER
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "AVLTree.h"
+
+//an AVL tree that many readers search while writers keep updating it (read-copy-update)
+//readers never block and never write to shared memory except their own epoch slot:
+//a writer builds the new version with insertAVLCopy()/deleteAVLCopy(), publishes the new root with one
+//atomic store and retires the replaced nodes, which are freed once no reader can still be looking at them
+//(epoch-based reclamation: a node retired in epoch e is freed after the global epoch has reached e + 2)
+//writers are serialized by a mutex, so the node pool may be used as long as only writers allocate
+
+#define CAVL_MAX_READERS 128
+#define CAVL_QUIESCENT ((unsigned long)-1)   //the epoch slot of a reader that is not inside the tree
+
+typedef struct CAVLReaderSlot {
+    atomic_ulong epoch;
+    char pad[64 - sizeof(atomic_ulong)];
+    //one cache line per reader, so announcing an epoch does not slow down the other readers
+} CAVLReaderSlot;
+
+typedef struct ConcurrentAVL {
+    AVLNode* _Atomic root;
+    atomic_ulong epoch;
+    pthread_mutex_t writeLock;
+    AVLNodeList retired[3];   //limbo lists of the last three epochs, retired[e % 3] collects epoch e
+    AVLNodeList replaced;     //scratch list of the update in progress
+    CAVLReaderSlot readers[CAVL_MAX_READERS];
+} ConcurrentAVL;
+
+void cavlInit(ConcurrentAVL* tree, AVLNode* root);   //takes over root, which may be NULL
+void cavlDestroy(ConcurrentAVL* tree);                //no reader or writer may be running
+
+int cavlContains(ConcurrentAVL* tree, int reader, int value);
+//lock-free lookup, reader is the caller's slot in [0, CAVL_MAX_READERS) and must not be shared by two threads
+void cavlInsert(ConcurrentAVL* tree, int value);
+void cavlDelete(ConcurrentAVL* tree, int value);
+
+#endif
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "AVLSet.h"
+
+#define PAR_MIN_HEIGHT 12
+//below this height (a few thousand keys) a new thread costs more than the work it takes over
+
+static int heightOf(AVLNode* node)
+{
+    return node == NULL ? -1 : node->height;
+}
+
+static AVLNode* joinRight(AVLNode* left, AVLNode* mid, AVLNode* right)
+{
+    //left is the taller tree: walk down its right spine until the subtree is short enough to sit next to right
+    if (heightOf(left) <= heightOf(right) + 1) {
+        mid->left = left;
+        mid->right = right;
+        updateAVL(mid);
+        return mid;
+    }
+    left->right = joinRight(left->right, mid, right);
+    return rebalanceAVL(left);
+    //the spine grows by at most one level, so one (double) rotation per level is enough
+}
+
+static AVLNode* joinLeft(AVLNode* left, AVLNode* mid, AVLNode* right)
+{
+    if (heightOf(right) <= heightOf(left) + 1) {
+        mid->left = left;
+        mid->right = right;
+        updateAVL(mid);
+        return mid;
+    }
+    right->left = joinLeft(left, mid, right->left);
+    return rebalanceAVL(right);
+}
+
+AVLNode* joinAVL(AVLNode* left, AVLNode* mid, AVLNode* right)
+{
+    if (heightOf(left) > heightOf(right) + 1) {
+        return joinRight(left, mid, right);
+    } else if (heightOf(right) > heightOf(left) + 1) {
+        return joinLeft(left, mid, right);
+    }
+    mid->left = left;
+    mid->right = right;
+    updateAVL(mid);
+    return mid;
+}
+
+static AVLNode* splitLast(AVLNode* root, AVLNode** rest)
+{
+    //detaches the maximum node, *rest gets the remaining tree
+    if (root->right == NULL) {
+        *rest = root->left;
+        return root;
+    }
+    AVLNode* restRight;
+    AVLNode* last = splitLast(root->right, &restRight);
+    *rest = joinAVL(root->left, root, restRight);
+    return last;
+}
+
+AVLNode* join2AVL(AVLNode* left, AVLNode* right)
+{
+    if (left == NULL) {
+        return right;
+    }
+    AVLNode* rest;
+    AVLNode* last = splitLast(left, &rest);
+    return joinAVL(rest, last, right);
+}
+
+AVLNode* splitAVL(AVLNode* root, int key, AVLNode** left, AVLNode** right)
+{
+    if (root == NULL) {
+        *left = NULL;
+        *right = NULL;
+        return NULL;
+    }
+    AVLNode* found;
+    if (key < root->val) {
+        AVLNode* bigger;
+        found = splitAVL(root->left, key, left, &bigger);
+        *right = joinAVL(bigger, root, root->right);
+    } else if (key > root->val) {
+        AVLNode* smaller;
+        found = splitAVL(root->right, key, &smaller, right);
+        *left = joinAVL(root->left, root, smaller);
+    } else {
+        *left = root->left;
+        *right = root->right;
+        found = root;
+        found->left = NULL;
+        found->right = NULL;
+        found->height = 0;
+        found->size = 1;
+    }
+    return found;
+}
+
+void destroyAVL(AVLNode* root)
+{
+    if (root == NULL) {
+        return;
+    }
+    destroyAVL(root->left);
+    destroyAVL(root->right);
+    freeAVLNode(root);
+}
+
+typedef enum { SET_UNION, SET_INTERSECT, SET_DIFFERENCE } SetOp;
+
+typedef struct SetTask {
+    SetOp op;
+    AVLNode* a;
+    AVLNode* b;
+    int forks;         //how many more times the recursion may fork a thread
+    AVLNode* result;
+} SetTask;
+
+static AVLNode* setOperation(SetOp op, AVLNode* a, AVLNode* b, int forks);
+
+static void* runSetTask(void* arg)
+{
+    SetTask* task = (SetTask*)arg;
+    task->result = setOperation(task->op, task->a, task->b, task->forks);
+    return NULL;
+}
+
+static AVLNode* setOperation(SetOp op, AVLNode* a, AVLNode* b, int forks)
+{
+    //the base cases: one of the two sets is empty
+    if (a == NULL || b == NULL) {
+        if (op == SET_UNION) {
+            return a != NULL ? a : b;
+        } else if (op == SET_INTERSECT) {
+            destroyAVL(a);
+            destroyAVL(b);
+            return NULL;
+        } else {
+            destroyAVL(b);
+            return a;
+        }
+    }
+
+    //split the other tree by the pivot, which is the root of a (the root of b for the difference)
+    AVLNode* pivot = op == SET_DIFFERENCE ? b : a;
+    AVLNode* pivotLeft = pivot->left;
+    AVLNode* pivotRight = pivot->right;
+    AVLNode* otherLeft;
+    AVLNode* otherRight;
+    AVLNode* found = splitAVL(op == SET_DIFFERENCE ? a : b, pivot->val, &otherLeft, &otherRight);
+
+    SetTask leftTask;
+    if (op == SET_DIFFERENCE) {
+        leftTask = (SetTask){ op, otherLeft, pivotLeft, forks / 2, NULL };
+    } else {
+        leftTask = (SetTask){ op, pivotLeft, otherLeft, forks / 2, NULL };
+    }
+    AVLNode* rightA = op == SET_DIFFERENCE ? otherRight : pivotRight;
+    AVLNode* rightB = op == SET_DIFFERENCE ? pivotRight : otherRight;
+
+    pthread_t thread;
+    int forked = 0;
+    if (forks > 0 && heightOf(leftTask.a) >= PAR_MIN_HEIGHT && heightOf(leftTask.b) >= PAR_MIN_HEIGHT) {
+        forked = pthread_create(&thread, NULL, runSetTask, &leftTask) == 0;
+        //if no thread can be created we simply do the left half ourselves
+    }
+    if (!forked) {
+        leftTask.forks = 0;
+        runSetTask(&leftTask);
+    }
+    AVLNode* rightResult = setOperation(op, rightA, rightB, forked ? forks - forks / 2 - 1 : forks);
+    if (forked) {
+        pthread_join(thread, NULL);
+    }
+    AVLNode* leftResult = leftTask.result;
+
+    //put the two halves back together around the pivot
+    if (op == SET_UNION) {
+        if (found != NULL) {
+            freeAVLNode(found);
+        }
+        return joinAVL(leftResult, pivot, rightResult);
+    } else if (op == SET_INTERSECT) {
+        if (found != NULL) {
+            freeAVLNode(found);
+            return joinAVL(leftResult, pivot, rightResult);
+        }
+        freeAVLNode(pivot);
+        return join2AVL(leftResult, rightResult);
+    } else {
+        if (found != NULL) {
+            freeAVLNode(found);
+        }
+        freeAVLNode(pivot);
+        return join2AVL(leftResult, rightResult);
+    }
+}
+
+AVLNode* unionAVL(AVLNode* a, AVLNode* b)
+{
+    return setOperation(SET_UNION, a, b, 0);
+}
+
+AVLNode* intersectAVL(AVLNode* a, AVLNode* b)
+{
+    return setOperation(SET_INTERSECT, a, b, 0);
+}
+
+AVLNode* differenceAVL(AVLNode* a, AVLNode* b)
+{
+    return setOperation(SET_DIFFERENCE, a, b, 0);
+}
+
+static int forksFor(int threads)
+{
+    //the pool hands out nodes without any locking, so it must not be used from several threads
+    if (getAVLPool() != NULL || threads < 2) {
+        return 0;
+    }
+    return threads - 1;
+}
+
+AVLNode* unionAVLPar(AVLNode* a, AVLNode* b, int threads)
+{
+    return setOperation(SET_UNION, a, b, forksFor(threads));
+}
+
+AVLNode* intersectAVLPar(AVLNode* a, AVLNode* b, int threads)
+{
+    return setOperation(SET_INTERSECT, a, b, forksFor(threads));
+}
+
+AVLNode* differenceAVLPar(AVLNode* a, AVLNode* b, int threads)
+{
+    return setOperation(SET_DIFFERENCE, a, b, forksFor(threads));
+}
@@ -0,0 +1,30 @@
+#ifndef AVL_SET_HEADER
+#define AVL_SET_HEADER
+
+#include "AVLTree.h"
+
+//set algebra on AVL trees built on join and split
+//the trees are treated as sets of distinct keys, and every function below consumes its input trees:
+//their nodes are reused in the result and the nodes that drop out are released with freeAVLNode()
+
+AVLNode* joinAVL(AVLNode* left, AVLNode* mid, AVLNode* right);
+//every key in left < mid->val < every key in right, returns the balanced tree holding all of them
+AVLNode* join2AVL(AVLNode* left, AVLNode* right);  //the same join without a middle node
+AVLNode* splitAVL(AVLNode* root, int key, AVLNode** left, AVLNode** right);
+//splits the tree into the keys smaller than key and the keys bigger than key
+//returns the detached node holding key, or NULL if key is not in the tree
+
+AVLNode* unionAVL(AVLNode* a, AVLNode* b);
+AVLNode* intersectAVL(AVLNode* a, AVLNode* b);
+AVLNode* differenceAVL(AVLNode* a, AVLNode* b);   //the keys of a that are not in b
+//all three take O(m log(n / m + 1)) time, where m <= n are the sizes of the two sets
+
+AVLNode* unionAVLPar(AVLNode* a, AVLNode* b, int threads);
+AVLNode* intersectAVLPar(AVLNode* a, AVLNode* b, int threads);
+AVLNode* differenceAVLPar(AVLNode* a, AVLNode* b, int threads);
+//fork-join versions: the two recursive halves run on different threads until about threads tasks exist
+//the node pool is not thread safe, so these run sequentially while setAVLPool() is in effect
+
+void destroyAVL(AVLNode* root);   //releases every node of the tree
+
+#endif
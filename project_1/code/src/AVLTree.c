@@ -1,6 +1,47 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "AVLTree.h"
+#include "treestats.h"
+#include "bulk.h"
+
+static NodePool* avlPool = NULL;
+//when a pool is set, all the nodes come from it instead of calloc()
+
+void setAVLPool(NodePool* pool)
+{
+    avlPool = pool;
+}
+
+NodePool* getAVLPool(void)
+{
+    return avlPool;
+}
+
+AVLNode* allocAVLNode(int value)
+{
+    AVLNode* currNode;
+    if (avlPool != NULL) {
+        currNode = (AVLNode*)poolAlloc(avlPool);
+    } else {
+        currNode = (AVLNode*)calloc(1, sizeof(AVLNode));
+    }
+    currNode->val = value;
+    currNode->height = 0;
+    currNode->size = 1;
+    currNode->refs = 0;
+    currNode->left = NULL;
+    currNode->right = NULL;
+    return currNode;
+}
+
+void freeAVLNode(AVLNode* node)
+{
+    if (avlPool != NULL) {
+        poolFree(avlPool, node);
+    } else {
+        free(node);
+    }
+}
 
 AVLNode* createAVL(AVLNode* root)
 {
@@ -12,8 +53,13 @@ AVLNode* createAVL(AVLNode* root)
     for (int i = 0; i < n; i ++) {
         scanf("%d", tempArr + i);
     }
-    for (int i = 0; i < n; i ++) {
-        root = insertAVL(root, tempArr[i]);
+    if (root == NULL) {
+        root = buildAVL(tempArr, n);
+        //an empty tree is bulk loaded in O(n) (O(n log n) if the input has to be sorted)
+    } else {
+        for (int i = 0; i < n; i ++) {
+            root = insertAVL(root, tempArr[i]);
+        }
     }
     free(tempArr);
     //free the space allocated
@@ -23,13 +69,10 @@ AVLNode* createAVL(AVLNode* root)
 AVLNode* insertAVL(AVLNode* node, int value)
 {
     if (node == NULL) {
-        AVLNode* currNode = (AVLNode*)calloc(1, sizeof(AVLNode));
-        currNode->val = value;
-        currNode->height = 0;
-        currNode->left = NULL;
-        currNode->right = NULL;
-        return currNode;
-    } else if (value < node->val) {
+        return allocAVLNode(value);
+    }
+    STATS_VISIT();
+    if (STATS_LT(value, node->val)) {
         //go to the left subtree
         node->left = insertAVL(node->left, value);
         //recursively solve the problem
@@ -51,23 +94,25 @@ AVLNode* deleteAVL(AVLNode* node, int value)
     //so we need to return the root of the tree where the deletion is already finished
     if (node == NULL) {
         return NULL;
-    } else if (value < node->val) {
+    }
+    STATS_VISIT();
+    if (STATS_LT(value, node->val)) {
         node->left = deleteAVL(node->left, value);
-    } else if (value > node->val) {
+    } else if (STATS_GT(value, node->val)) {
         node->right = deleteAVL(node->right, value);
         //in these two cases, we recursively delete the AVL in the subtree
     } else {
         //this is the case where the node to be deleted is found
         if (node->left == NULL && node->right == NULL) {
-            free(node);
+            freeAVLNode(node);
             return NULL;
         } else if (node->left == NULL) {
             AVLNode* tmp = node->right;
-            free(node);
+            freeAVLNode(node);
             return tmp;
         } else if (node->right == NULL) {
             AVLNode* tmp = node->left;
-            free(node);
+            freeAVLNode(node);
             return tmp;
         } else {
             int minRight = minVal(node->right);
@@ -87,8 +132,8 @@ AVLNode* leftRotate(AVLNode* node)
     AVLNode* R = node->right;
     R->left = node;
     node->right = RL;
-    node->height = getHeight(node);
-    R->height = getHeight(R);
+    updateAVL(node);
+    updateAVL(R);
     return R;
 }
 //return the new root
@@ -99,33 +144,39 @@ AVLNode* rightRotate(AVLNode* node)
     AVLNode* L = node->left;
     L->right = node;
     node->left = LR;
-    node->height = getHeight(node);
-    L->height = getHeight(L);
+    updateAVL(node);
+    updateAVL(L);
     return L;
 }
 
 AVLNode* rebalanceAVL(AVLNode* node)
 {
-    node->height = getHeight(node);
+    updateAVL(node);
+    //the size is refreshed together with the height, so every path that rebalances also keeps the sizes right
     int currBF = getBF(node);
     if (currBF == -2) {
         //the height of the left side is shorter
-        if (getBF(node->right) < 0) {
+        if (getBF(node->right) <= 0) {
             //this is the RR case
+            //a deletion can leave the right child balanced, and then a single rotation is the right fix as well
+            STATS_COUNT(rotRR);
             node = leftRotate(node);
         } else {
             //this is the RL case
+            STATS_COUNT(rotRL);
             node->right = rightRotate(node->right);
             node = leftRotate(node);
         }
         
     } else if (currBF == 2) {
         //right side is shorter
-        if (getBF(node->left) > 0) {
-            //LL case
+        if (getBF(node->left) >= 0) {
+            //LL case, including a balanced left child after a deletion
+            STATS_COUNT(rotLL);
             node = rightRotate(node);
         } else {
             //LR case
+            STATS_COUNT(rotLR);
             node->left = leftRotate(node->left);
             node = rightRotate(node);
         }
@@ -163,6 +214,17 @@ int getHeight(AVLNode* node)
     //get the higher height
 }
 
+int getSize(AVLNode* node)
+{
+    return node == NULL ? 0 : node->size;
+}
+
+void updateAVL(AVLNode* node)
+{
+    node->height = getHeight(node);
+    node->size = getSize(node->left) + getSize(node->right) + 1;
+}
+
 int getBF(AVLNode* node)
 {
     if (node == NULL) {
@@ -185,10 +247,364 @@ int getBF(AVLNode* node)
 
 int minVal(AVLNode* node)
 {
+    STATS_VISIT();
     if (node->left == NULL) {
         return node->val;
     } else {
         return minVal(node->left);
     }
     //find the min value in the designated subtree
-}
\ No newline at end of file
+}
+
+AVLNode* insertAVLIter(AVLNode* root, int value)
+{
+    AVLNode** path[AVL_MAX_DEPTH];
+    //path[i] is the link in the parent that points to the i-th node on the way down
+    int depth = 0;
+    AVLNode** link = &root;
+    while (*link != NULL) {
+        path[depth++] = link;
+        STATS_VISIT();
+        if (STATS_LT(value, (*link)->val)) {
+            link = &(*link)->left;
+        } else {
+            link = &(*link)->right;
+        }
+    }
+    *link = allocAVLNode(value);
+    //retrace from the parent of the new leaf up to the root
+    while (depth > 0) {
+        link = path[--depth];
+        int oldHeight = (*link)->height;
+        *link = rebalanceAVL(*link);
+        if ((*link)->height == oldHeight) {
+            break;
+            //the height of this subtree did not change (or a rotation restored it),
+            //so nothing above it can be out of balance
+        }
+    }
+    while (depth > 0) {
+        (*path[--depth])->size++;
+        //the rest of the path only has to count the new key
+    }
+    return root;
+}
+
+AVLNode* deleteAVLIter(AVLNode* root, int value)
+{
+    AVLNode** path[AVL_MAX_DEPTH];
+    int depth = 0;
+    AVLNode** link = &root;
+    while (*link != NULL && !STATS_EQ((*link)->val, value)) {
+        path[depth++] = link;
+        STATS_VISIT();
+        if (STATS_LT(value, (*link)->val)) {
+            link = &(*link)->left;
+        } else {
+            link = &(*link)->right;
+        }
+    }
+    AVLNode* node = *link;
+    if (node == NULL) {
+        return root;
+        //the value is not in the tree
+    }
+    if (node->left != NULL && node->right != NULL) {
+        //replace the value with the minimum of the right subtree and remove that node instead
+        path[depth++] = link;
+        link = &node->right;
+        while ((*link)->left != NULL) {
+            path[depth++] = link;
+            STATS_VISIT();
+            link = &(*link)->left;
+        }
+        AVLNode* minNode = *link;
+        node->val = minNode->val;
+        *link = minNode->right;
+        freeAVLNode(minNode);
+    } else {
+        *link = node->left != NULL ? node->left : node->right;
+        freeAVLNode(node);
+    }
+    while (depth > 0) {
+        link = path[--depth];
+        int oldHeight = (*link)->height;
+        *link = rebalanceAVL(*link);
+        if ((*link)->height == oldHeight) {
+            break;
+        }
+    }
+    while (depth > 0) {
+        (*path[--depth])->size--;
+    }
+    return root;
+}
+
+AVLNode* searchAVL(AVLNode* node, int value)
+{
+    while (node != NULL && !STATS_EQ(node->val, value)) {
+        STATS_VISIT();
+        node = STATS_LT(value, node->val) ? node->left : node->right;
+    }
+    return node;
+}
+
+
+int rankAVL(AVLNode* root, int value)
+{
+    int rank = 0;
+    while (root != NULL) {
+        if (value <= root->val) {
+            root = root->left;
+        } else {
+            rank += getSize(root->left) + 1;
+            //root and its whole left subtree are smaller than value
+            root = root->right;
+        }
+    }
+    return rank;
+}
+
+AVLNode* selectAVL(AVLNode* root, int k)
+{
+    while (root != NULL) {
+        int leftSize = getSize(root->left);
+        if (k <= leftSize) {
+            root = root->left;
+        } else if (k == leftSize + 1) {
+            return root;
+        } else {
+            k -= leftSize + 1;
+            root = root->right;
+        }
+    }
+    return NULL;
+}
+
+static int countAtMost(AVLNode* root, int value)
+{
+    //the number of keys <= value, the same walk as rankAVL() with the comparison flipped
+    int count = 0;
+    while (root != NULL) {
+        if (value < root->val) {
+            root = root->left;
+        } else {
+            count += getSize(root->left) + 1;
+            root = root->right;
+        }
+    }
+    return count;
+}
+
+int countRange(AVLNode* root, int lo, int hi)
+{
+    if (lo > hi) {
+        return 0;
+    }
+    return countAtMost(root, hi) - rankAVL(root, lo);
+}
+
+void appendAVLNode(AVLNodeList* list, AVLNode* node)
+{
+    if (list == NULL) {
+        return;
+    }
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        list->nodes = (AVLNode**)realloc(list->nodes, sizeof(AVLNode*) * list->capacity);
+    }
+    list->nodes[list->count++] = node;
+}
+
+typedef struct CopyContext {
+    AVLNodeList* replaced;
+    AVLNode* fresh[AVL_MAX_DEPTH * 3];
+    //the copies made by this update, they are not shared yet and may be changed in place
+    int freshCount;
+} CopyContext;
+
+static AVLNode* copyAVLNode(CopyContext* context, AVLNode* node)
+{
+    AVLNode* copy = allocAVLNode(node->val);
+    *copy = *node;
+    copy->refs = 0;
+    appendAVLNode(context->replaced, node);
+    context->fresh[context->freshCount++] = copy;
+    return copy;
+}
+
+static AVLNode* freshAVLNode(CopyContext* context, AVLNode* node)
+{
+    for (int i = 0; i < context->freshCount; i ++) {
+        if (context->fresh[i] == node) {
+            return node;
+        }
+    }
+    return copyAVLNode(context, node);
+}
+
+static AVLNode* rebalanceCopy(CopyContext* context, AVLNode* node)
+{
+    //node is fresh, but a rotation also rewires a child and maybe a grandchild,
+    //so those are copied first unless they are fresh already (after a deletion they are old nodes)
+    updateAVL(node);
+    int currBF = getBF(node);
+    if (currBF == -2) {
+        node->right = freshAVLNode(context, node->right);
+        if (getBF(node->right) <= 0) {
+            STATS_COUNT(rotRR);
+        } else {
+            STATS_COUNT(rotRL);
+            node->right->left = freshAVLNode(context, node->right->left);
+            node->right = rightRotate(node->right);
+        }
+        node = leftRotate(node);
+    } else if (currBF == 2) {
+        node->left = freshAVLNode(context, node->left);
+        if (getBF(node->left) >= 0) {
+            STATS_COUNT(rotLL);
+        } else {
+            STATS_COUNT(rotLR);
+            node->left->right = freshAVLNode(context, node->left->right);
+            node->left = leftRotate(node->left);
+        }
+        node = rightRotate(node);
+    }
+    return node;
+}
+
+static AVLNode* insertCopy(CopyContext* context, AVLNode* node, int value)
+{
+    if (node == NULL) {
+        AVLNode* leaf = allocAVLNode(value);
+        context->fresh[context->freshCount++] = leaf;
+        return leaf;
+    }
+    STATS_VISIT();
+    if (STATS_EQ(value, node->val)) {
+        return node;
+    }
+    int goLeft = STATS_LT(value, node->val);
+    AVLNode* child = goLeft ? node->left : node->right;
+    AVLNode* newChild = insertCopy(context, child, value);
+    if (newChild == child) {
+        return node;
+        //the value was already there, so this subtree is unchanged
+    }
+    node = copyAVLNode(context, node);
+    //the nodes on the path always come from the old tree
+    if (goLeft) {
+        node->left = newChild;
+    } else {
+        node->right = newChild;
+    }
+    return rebalanceCopy(context, node);
+}
+
+static AVLNode* deleteCopy(CopyContext* context, AVLNode* node, int value, int* found)
+{
+    if (node == NULL) {
+        return NULL;
+    }
+    STATS_VISIT();
+    if (STATS_EQ(value, node->val)) {
+        *found = 1;
+        if (node->left == NULL || node->right == NULL) {
+            appendAVLNode(context->replaced, node);
+            return node->left != NULL ? node->left : node->right;
+        }
+        //two subtrees: a copy of node takes over the minimum of the right subtree, which is removed there
+        int minRight = minVal(node->right);
+        AVLNode* newRight = deleteCopy(context, node->right, minRight, found);
+        node = copyAVLNode(context, node);
+        node->val = minRight;
+        node->right = newRight;
+        return rebalanceCopy(context, node);
+    }
+    int goLeft = STATS_LT(value, node->val);
+    AVLNode* newChild = deleteCopy(context, goLeft ? node->left : node->right, value, found);
+    if (!*found) {
+        return node;
+    }
+    node = copyAVLNode(context, node);
+    if (goLeft) {
+        node->left = newChild;
+    } else {
+        node->right = newChild;
+    }
+    return rebalanceCopy(context, node);
+}
+
+AVLNode* insertAVLCopy(AVLNode* root, int value, AVLNodeList* replaced)
+{
+    CopyContext context;
+    context.replaced = replaced;
+    context.freshCount = 0;
+    return insertCopy(&context, root, value);
+}
+
+AVLNode* deleteAVLCopy(AVLNode* root, int value, AVLNodeList* replaced)
+{
+    CopyContext context;
+    int found = 0;
+    context.replaced = replaced;
+    context.freshCount = 0;
+    return deleteCopy(&context, root, value, &found);
+}
+
+static AVLNode* shareCopies(CopyContext* context, AVLNode* oldRoot, AVLNode* newRoot)
+{
+    //the copies are the only new parents in the new version, so each of their children gains one reference;
+    //the nodes of the old version keep the references they had
+    if (newRoot == oldRoot) {
+        return retainAVL(oldRoot);
+        //nothing changed, the new version is the old one
+    }
+    for (int i = 0; i < context->freshCount; i ++) {
+        AVLNode* node = context->fresh[i];
+        if (node->left != NULL) {
+            node->left->refs++;
+        }
+        if (node->right != NULL) {
+            node->right->refs++;
+        }
+    }
+    return retainAVL(newRoot);
+}
+
+AVLNode* insertAVLPersistent(AVLNode* root, int value)
+{
+    CopyContext context;
+    context.replaced = NULL;
+    context.freshCount = 0;
+    return shareCopies(&context, root, insertCopy(&context, root, value));
+}
+
+AVLNode* deleteAVLPersistent(AVLNode* root, int value)
+{
+    CopyContext context;
+    int found = 0;
+    context.replaced = NULL;
+    context.freshCount = 0;
+    return shareCopies(&context, root, deleteCopy(&context, root, value, &found));
+}
+
+AVLNode* retainAVL(AVLNode* root)
+{
+    if (root != NULL) {
+        root->refs++;
+    }
+    return root;
+}
+
+void releaseAVL(AVLNode* root)
+{
+    //a node goes away with its last reference, and then its children lose one each;
+    //the recursion only goes on below nodes that are freed, so it is as deep as the tree at most
+    if (root == NULL || --root->refs > 0) {
+        return;
+    }
+    releaseAVL(root->left);
+    releaseAVL(root->right);
+    freeAVLNode(root);
+}
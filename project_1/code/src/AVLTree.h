@@ -3,11 +3,19 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include "pool.h"
+
+#define AVL_MAX_DEPTH 64
+//an AVL tree with n nodes is at most 1.44 * log2(n + 2) high, so 64 levels cover any tree that fits in memory
 
 typedef struct AVLNode {
     int val;
     int height;
     //the height of the current node
+    int size;
+    //the number of nodes in the subtree rooted here, used for the order statistics
+    int refs;
+    //the number of parents and version handles sharing this node, only used by the persistent mode
     struct AVLNode* left;
     struct AVLNode* right;
 } AVLNode;
@@ -18,13 +26,52 @@ AVLNode* deleteAVL(AVLNode* node, int value);
 AVLNode* rebalanceAVL(AVLNode* node);
 AVLNode* leftRotate(AVLNode* node);   //left turn the node
 AVLNode* rightRotate(AVLNode* node);  //right turn the node
+AVLNode* insertAVLIter(AVLNode* root, int value);  //iterative insertAVL() with an explicit path stack
+AVLNode* deleteAVLIter(AVLNode* root, int value);  //iterative deleteAVL() with an explicit path stack
 
 //above are all the AVL manipulation function
 //all of the above actions will return the root of the current local tree
 
 int getHeight(AVLNode* node);
+int getSize(AVLNode* node);   //0 for an empty subtree
+void updateAVL(AVLNode* node);    //recomputes height and size from the children
 int getBF(AVLNode* node);
 int minVal(AVLNode* node);    //minimum value in the right subtree
+AVLNode* searchAVL(AVLNode* node, int value);  //the node holding value, NULL if it is not in the tree
 //above are some of the helper functions
 
+int rankAVL(AVLNode* root, int value);     //the number of keys smaller than value
+AVLNode* selectAVL(AVLNode* root, int k);  //the node holding the k-th smallest key (k starts at 1), NULL if k is out of range
+int countRange(AVLNode* root, int lo, int hi);  //the number of keys in [lo, hi]
+//order statistics, all O(log n) thanks to the subtree sizes
+
+typedef struct AVLNodeList {
+    AVLNode** nodes;
+    int count;
+    int capacity;
+} AVLNodeList;
+
+AVLNode* insertAVLCopy(AVLNode* root, int value, AVLNodeList* replaced);
+AVLNode* deleteAVLCopy(AVLNode* root, int value, AVLNodeList* replaced);
+//path-copying updates: no node of root is modified, the O(log n) nodes on the path are copied instead
+//and the new root is returned, so root stays a valid tree for whoever still reads it
+//every node of root that the new tree no longer uses is appended to replaced, the caller decides when to free it
+//a duplicated value is ignored, nothing is copied then
+void appendAVLNode(AVLNodeList* list, AVLNode* node);  //a NULL list ignores the node
+
+AVLNode* insertAVLPersistent(AVLNode* root, int value);
+AVLNode* deleteAVLPersistent(AVLNode* root, int value);
+//the persistent mode: the same path copying, but the versions share their nodes through reference counts
+//root is left as it is, the new version comes with one reference that belongs to the caller
+//a version is dropped with releaseAVL() once nobody reads it any more, e.g. right after the update
+//the versions have to start from NULL, a tree built by insertAVL() has no reference counts
+AVLNode* retainAVL(AVLNode* root);  //an O(1) snapshot: one more reference to the version, returns root
+void releaseAVL(AVLNode* root);     //drops one reference and frees the nodes that no other version shares
+
+void setAVLPool(NodePool* pool);  //allocate nodes from the pool, NULL goes back to calloc/free
+NodePool* getAVLPool(void);
+AVLNode* allocAVLNode(int value); //a new leaf holding value
+void freeAVLNode(AVLNode* node);
+//every AVL node is created and released through these two functions
+
 #endif
\ No newline at end of file
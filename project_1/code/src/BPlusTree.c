@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "BPlusTree.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BPT_HAVE_AVX2_KERNEL
+#endif
+
+static int countLessScalar(const int* keys, int key)
+{
+    int count = 0;
+    for (int j = 0; j < BPT_KEYS; j ++) {
+        count += keys[j] < key;
+        //no early exit, so the compiler can unroll the loop without branches
+    }
+    return count;
+}
+
+#ifdef BPT_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+static int countLessAVX2(const int* keys, int key)
+{
+    //compare 8 keys per instruction and count the lanes that are smaller than key
+    __m256i target = _mm256_set1_epi32(key);
+    int count = 0;
+    for (int j = 0; j < BPT_KEYS; j += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(keys + j));
+        __m256i less = _mm256_cmpgt_epi32(target, block);
+        count += __builtin_popcount((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(less)));
+    }
+    return count;
+}
+#endif
+
+static int countLessDetect(const int* keys, int key);
+static int (*countLess)(const int* keys, int key) = countLessDetect;
+//the number of keys in a node that are smaller than key, which is the position of key in that node
+//the first call picks the AVX2 kernel if the CPU supports it, every later call goes there directly
+
+static int countLessDetect(const int* keys, int key)
+{
+    countLess = countLessScalar;
+#ifdef BPT_HAVE_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2")) {
+        countLess = countLessAVX2;
+    }
+#endif
+    return countLess(keys, key);
+}
+
+static int childIndex(const BPTNode* node, int key)
+{
+    //the number of keys <= key: equal keys were moved to the right when their node was split
+    return key == INT_MAX ? node->count : countLess(node->keys, key + 1);
+}
+
+static void padKeys(BPTNode* node)
+{
+    for (int j = node->count; j < BPT_KEYS; j ++) {
+        node->keys[j] = INT_MAX;
+    }
+}
+
+static BPTLeaf* newLeaf(void)
+{
+    BPTLeaf* leaf = (BPTLeaf*)malloc(sizeof(BPTLeaf));
+    leaf->base.count = 0;
+    leaf->base.isLeaf = 1;
+    leaf->next = NULL;
+    padKeys(&leaf->base);
+    return leaf;
+}
+
+static BPTInner* newInner(void)
+{
+    BPTInner* inner = (BPTInner*)malloc(sizeof(BPTInner));
+    inner->base.count = 0;
+    inner->base.isLeaf = 0;
+    padKeys(&inner->base);
+    return inner;
+}
+
+static BPTNode* insertInto(BPTNode* node, int value, int* upKey)
+{
+    //returns the new right sibling if node had to be split, and *upKey is the key that separates them
+    if (node->isLeaf) {
+        int pos = countLess(node->keys, value);
+        if (pos < node->count && node->keys[pos] == value) {
+            return NULL;
+        }
+        if (node->count < BPT_KEYS) {
+            memmove(node->keys + pos + 1, node->keys + pos, sizeof(int) * (node->count - pos));
+            node->keys[pos] = value;
+            node->count ++;
+            return NULL;
+        }
+        //the leaf is full: spread the BPT_KEYS + 1 keys over two leaves
+        int all[BPT_KEYS + 1];
+        memcpy(all, node->keys, sizeof(int) * pos);
+        all[pos] = value;
+        memcpy(all + pos + 1, node->keys + pos, sizeof(int) * (BPT_KEYS - pos));
+        BPTLeaf* leaf = (BPTLeaf*)node;
+        BPTLeaf* right = newLeaf();
+        int leftCount = (BPT_KEYS + 1) / 2;
+        memcpy(node->keys, all, sizeof(int) * leftCount);
+        node->count = leftCount;
+        padKeys(node);
+        memcpy(right->base.keys, all + leftCount, sizeof(int) * (BPT_KEYS + 1 - leftCount));
+        right->base.count = BPT_KEYS + 1 - leftCount;
+        right->next = leaf->next;
+        leaf->next = right;
+        *upKey = right->base.keys[0];
+        return &right->base;
+    }
+
+    BPTInner* inner = (BPTInner*)node;
+    int i = childIndex(node, value);
+    int childKey;
+    BPTNode* sibling = insertInto(inner->children[i], value, &childKey);
+    if (sibling == NULL) {
+        return NULL;
+    }
+    if (node->count < BPT_KEYS) {
+        memmove(node->keys + i + 1, node->keys + i, sizeof(int) * (node->count - i));
+        memmove(inner->children + i + 2, inner->children + i + 1, sizeof(BPTNode*) * (node->count - i));
+        node->keys[i] = childKey;
+        inner->children[i + 1] = sibling;
+        node->count ++;
+        return NULL;
+    }
+    //the inner node is full as well: the middle key moves up, the rest is spread over two nodes
+    int keys[BPT_KEYS + 1];
+    BPTNode* children[BPT_KEYS + 2];
+    memcpy(keys, node->keys, sizeof(int) * i);
+    keys[i] = childKey;
+    memcpy(keys + i + 1, node->keys + i, sizeof(int) * (BPT_KEYS - i));
+    memcpy(children, inner->children, sizeof(BPTNode*) * (i + 1));
+    children[i + 1] = sibling;
+    memcpy(children + i + 2, inner->children + i + 1, sizeof(BPTNode*) * (BPT_KEYS - i));
+    int leftCount = (BPT_KEYS + 1) / 2;
+    BPTInner* right = newInner();
+    memcpy(node->keys, keys, sizeof(int) * leftCount);
+    memcpy(inner->children, children, sizeof(BPTNode*) * (leftCount + 1));
+    node->count = leftCount;
+    padKeys(node);
+    right->base.count = BPT_KEYS - leftCount;
+    memcpy(right->base.keys, keys + leftCount + 1, sizeof(int) * right->base.count);
+    memcpy(right->children, children + leftCount + 1, sizeof(BPTNode*) * (right->base.count + 1));
+    *upKey = keys[leftCount];
+    return &right->base;
+}
+
+BPTNode* insertBPT(BPTNode* root, int value)
+{
+    if (root == NULL) {
+        BPTLeaf* leaf = newLeaf();
+        leaf->base.keys[0] = value;
+        leaf->base.count = 1;
+        return &leaf->base;
+    }
+    int upKey;
+    BPTNode* sibling = insertInto(root, value, &upKey);
+    if (sibling != NULL) {
+        //the root was split, so the tree grows by one level
+        BPTInner* newRoot = newInner();
+        newRoot->base.keys[0] = upKey;
+        newRoot->base.count = 1;
+        newRoot->children[0] = root;
+        newRoot->children[1] = sibling;
+        return &newRoot->base;
+    }
+    return root;
+}
+
+static void borrowFromLeft(BPTInner* parent, int i)
+{
+    BPTNode* left = parent->children[i - 1];
+    BPTNode* child = parent->children[i];
+    memmove(child->keys + 1, child->keys, sizeof(int) * child->count);
+    if (child->isLeaf) {
+        child->keys[0] = left->keys[left->count - 1];
+        parent->base.keys[i - 1] = child->keys[0];
+    } else {
+        //rotate through the parent: the separator comes down, the last key of left goes up
+        BPTInner* childInner = (BPTInner*)child;
+        BPTInner* leftInner = (BPTInner*)left;
+        memmove(childInner->children + 1, childInner->children, sizeof(BPTNode*) * (child->count + 1));
+        child->keys[0] = parent->base.keys[i - 1];
+        childInner->children[0] = leftInner->children[left->count];
+        parent->base.keys[i - 1] = left->keys[left->count - 1];
+    }
+    child->count ++;
+    left->count --;
+    padKeys(left);
+}
+
+static void borrowFromRight(BPTInner* parent, int i)
+{
+    BPTNode* child = parent->children[i];
+    BPTNode* right = parent->children[i + 1];
+    if (child->isLeaf) {
+        child->keys[child->count] = right->keys[0];
+        memmove(right->keys, right->keys + 1, sizeof(int) * (right->count - 1));
+    } else {
+        BPTInner* childInner = (BPTInner*)child;
+        BPTInner* rightInner = (BPTInner*)right;
+        child->keys[child->count] = parent->base.keys[i];
+        childInner->children[child->count + 1] = rightInner->children[0];
+        parent->base.keys[i] = right->keys[0];
+        memmove(right->keys, right->keys + 1, sizeof(int) * (right->count - 1));
+        memmove(rightInner->children, rightInner->children + 1, sizeof(BPTNode*) * right->count);
+    }
+    child->count ++;
+    right->count --;
+    padKeys(right);
+    if (child->isLeaf) {
+        parent->base.keys[i] = right->keys[0];
+    }
+}
+
+static void mergeChildren(BPTInner* parent, int j)
+{
+    //children[j + 1] is appended to children[j] and removed from the parent together with keys[j]
+    BPTNode* left = parent->children[j];
+    BPTNode* right = parent->children[j + 1];
+    if (left->isLeaf) {
+        memcpy(left->keys + left->count, right->keys, sizeof(int) * right->count);
+        left->count += right->count;
+        ((BPTLeaf*)left)->next = ((BPTLeaf*)right)->next;
+    } else {
+        BPTInner* leftInner = (BPTInner*)left;
+        left->keys[left->count] = parent->base.keys[j];
+        memcpy(left->keys + left->count + 1, right->keys, sizeof(int) * right->count);
+        memcpy(leftInner->children + left->count + 1, ((BPTInner*)right)->children, sizeof(BPTNode*) * (right->count + 1));
+        left->count += right->count + 1;
+    }
+    free(right);
+    BPTNode* node = &parent->base;
+    memmove(node->keys + j, node->keys + j + 1, sizeof(int) * (node->count - j - 1));
+    memmove(parent->children + j + 1, parent->children + j + 2, sizeof(BPTNode*) * (node->count - j - 1));
+    node->count --;
+    padKeys(node);
+}
+
+static int deleteFrom(BPTNode* node, int value)
+{
+    //returns 1 if value was found and removed
+    if (node->isLeaf) {
+        int pos = countLess(node->keys, value);
+        if (pos >= node->count || node->keys[pos] != value) {
+            return 0;
+        }
+        memmove(node->keys + pos, node->keys + pos + 1, sizeof(int) * (node->count - pos - 1));
+        node->count --;
+        node->keys[node->count] = INT_MAX;
+        return 1;
+    }
+    BPTInner* inner = (BPTInner*)node;
+    int i = childIndex(node, value);
+    if (!deleteFrom(inner->children[i], value)) {
+        return 0;
+    }
+    if (inner->children[i]->count < BPT_MIN_KEYS) {
+        //the child is too small now: borrow a key from a sibling that can spare one, or merge with it
+        if (i > 0 && inner->children[i - 1]->count > BPT_MIN_KEYS) {
+            borrowFromLeft(inner, i);
+        } else if (i < node->count && inner->children[i + 1]->count > BPT_MIN_KEYS) {
+            borrowFromRight(inner, i);
+        } else if (i > 0) {
+            mergeChildren(inner, i - 1);
+        } else {
+            mergeChildren(inner, i);
+        }
+    }
+    return 1;
+}
+
+BPTNode* deleteBPT(BPTNode* root, int value)
+{
+    if (root == NULL) {
+        return NULL;
+    }
+    deleteFrom(root, value);
+    if (root->count == 0) {
+        //an empty inner root has a single child left, which becomes the new root
+        BPTNode* newRoot = root->isLeaf ? NULL : ((BPTInner*)root)->children[0];
+        free(root);
+        return newRoot;
+    }
+    return root;
+}
+
+static BPTLeaf* findLeaf(BPTNode* node, int value)
+{
+    while (!node->isLeaf) {
+        node = ((BPTInner*)node)->children[childIndex(node, value)];
+    }
+    return (BPTLeaf*)node;
+}
+
+int searchBPT(BPTNode* root, int value)
+{
+    if (root == NULL) {
+        return 0;
+    }
+    BPTLeaf* leaf = findLeaf(root, value);
+    int pos = countLess(leaf->base.keys, value);
+    return pos < leaf->base.count && leaf->base.keys[pos] == value;
+}
+
+int countRangeBPT(BPTNode* root, int lo, int hi)
+{
+    if (root == NULL || lo > hi) {
+        return 0;
+    }
+    BPTLeaf* leaf = findLeaf(root, lo);
+    int count = 0;
+    int pos = countLess(leaf->base.keys, lo);
+    while (leaf != NULL) {
+        //from the first key >= lo, walk along the leaves until a key is bigger than hi
+        for (; pos < leaf->base.count; pos ++) {
+            if (leaf->base.keys[pos] > hi) {
+                return count;
+            }
+            count ++;
+        }
+        leaf = leaf->next;
+        pos = 0;
+    }
+    return count;
+}
+
+void freeBPT(BPTNode* root)
+{
+    if (root == NULL) {
+        return;
+    }
+    if (!root->isLeaf) {
+        BPTInner* inner = (BPTInner*)root;
+        for (int i = 0; i <= root->count; i ++) {
+            freeBPT(inner->children[i]);
+        }
+    }
+    free(root);
+}
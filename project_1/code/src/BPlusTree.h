@@ -0,0 +1,45 @@
+#ifndef BPT_HEADER
+#define BPT_HEADER
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//B+-tree with the same insert/delete/search interface as AVLTree.h
+//every node holds a block of BPT_NODE_BYTES bytes of keys, which is searched with AVX2 when the CPU has it
+//the keys live only in the leaves, and the leaves are linked for range scans
+
+#ifndef BPT_NODE_BYTES
+#define BPT_NODE_BYTES 128
+//64, 128 or 256: one, two or four cache lines of keys per node
+#endif
+#if BPT_NODE_BYTES % 32 != 0 || BPT_NODE_BYTES < 32
+#error "BPT_NODE_BYTES must be a multiple of 32, the in-node search compares 8 keys at a time"
+#endif
+
+#define BPT_KEYS (BPT_NODE_BYTES / (int)sizeof(int))   //maximum number of keys in a node
+#define BPT_MIN_KEYS (BPT_KEYS / 2)                     //minimum number of keys in a node that is not the root
+
+typedef struct BPTNode {
+    int keys[BPT_KEYS];   //the unused slots hold INT_MAX, so the whole block can always be compared at once
+    int count;            //number of keys in use
+    int isLeaf;
+} BPTNode;
+
+typedef struct BPTLeaf {
+    BPTNode base;
+    struct BPTLeaf* next;   //the leaf with the next bigger keys
+} BPTLeaf;
+
+typedef struct BPTInner {
+    BPTNode base;
+    BPTNode* children[BPT_KEYS + 1];
+    //children[i] holds the keys in [keys[i - 1], keys[i])
+} BPTInner;
+
+BPTNode* insertBPT(BPTNode* root, int value);   //returns the root, a duplicated value is ignored
+BPTNode* deleteBPT(BPTNode* root, int value);
+int searchBPT(BPTNode* root, int value);        //1 if value is in the tree
+int countRangeBPT(BPTNode* root, int lo, int hi);  //the number of keys in [lo, hi], walks the linked leaves
+void freeBPT(BPTNode* root);
+
+#endif
@@ -1,6 +1,38 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "BST.h"
+#include "bulk.h"
+
+static NodePool* bstPool = NULL;
+//when a pool is set, all the nodes come from it instead of calloc()
+
+void setBSTPool(NodePool* pool)
+{
+    bstPool = pool;
+}
+
+BSTNode* allocBSTNode(int value)
+{
+    BSTNode* currNode;
+    if (bstPool != NULL) {
+        currNode = (BSTNode*)poolAlloc(bstPool);
+    } else {
+        currNode = (BSTNode*)calloc(1, sizeof(BSTNode));
+    }
+    currNode->val = value;
+    currNode->left = NULL;
+    currNode->right = NULL;
+    return currNode;
+}
+
+void freeBSTNode(BSTNode* node)
+{
+    if (bstPool != NULL) {
+        poolFree(bstPool, node);
+    } else {
+        free(node);
+    }
+}
 
 BSTNode* createBST(BSTNode* root)
 {
@@ -12,9 +44,14 @@ BSTNode* createBST(BSTNode* root)
         scanf("%d", tempArray + i);
         //get the data into the temparray
     }
-    for (int i = 0; i < n; i ++) {
-        root = insertBST(root, tempArray[i]);
-        //insert the variables into the tree
+    if (root == NULL) {
+        root = buildBST(tempArray, n);
+        //an empty tree is bulk loaded, which also avoids the O(n^2) chain on sorted input
+    } else {
+        for (int i = 0; i < n; i ++) {
+            root = insertBST(root, tempArray[i]);
+            //insert the variables into the tree
+        }
     }
     free(tempArray);
     return root;
@@ -23,22 +60,18 @@ BSTNode* createBST(BSTNode* root)
 BSTNode* insertBST(BSTNode* node, int value)
 {
     if (node == NULL) {
-        BSTNode* currNode = (BSTNode* )calloc(1, sizeof(BSTNode));
-        currNode->val = value;
-        currNode->left = NULL;
-        currNode->right = NULL;
         //create the first node if the root is NULL
-        return currNode;
+        return allocBSTNode(value);
     } else {
         if (value < node->val) {
             //we recursively solve the problem
             node->left = insertBST(node->left, value);
         } else if (value > node->val){
             node->right = insertBST(node->right, value);
-        } else {
-            return node;
         }
     }
+    return node;
+    //a duplicated value is simply ignored
 }
 
 BSTNode* deleteBST(BSTNode* node, int value)
@@ -54,11 +87,11 @@ BSTNode* deleteBST(BSTNode* node, int value)
         //this is the node we are looking for
         if (node->left == NULL) {
             BSTNode* temp = node->right;
-            free(node);
+            freeBSTNode(node);
             return temp;
         } else if (node->right == NULL) {
             BSTNode* temp = node->left;
-            free(node);
+            freeBSTNode(node);
             return temp;
             //in these two cases, we directly delete the node and return the single-subtree
         } else {
@@ -67,8 +100,8 @@ BSTNode* deleteBST(BSTNode* node, int value)
             node->right = deleteBST(node->right, rightMin);
             //here we find the minimum node in the right subtree and replace the node to be deleted with this node
         }
-        return node;
     }
+    return node;
 }
 
 int findMin(BSTNode* node)
@@ -80,4 +113,65 @@ int findMin(BSTNode* node)
     }
     //we use this helper function to find the minimum value in the right subtree
     //however, we need to be sure that the first call must satisfies that the right subtree exists
-}
\ No newline at end of file
+}
+
+BSTNode* insertBSTIter(BSTNode* root, int value)
+{
+    BSTNode** link = &root;
+    //we walk down the links instead of the nodes, so the new node can be hung directly on its parent
+    while (*link != NULL) {
+        if (value < (*link)->val) {
+            link = &(*link)->left;
+        } else if (value > (*link)->val) {
+            link = &(*link)->right;
+        } else {
+            return root;
+            //the value is already in the tree
+        }
+    }
+    *link = allocBSTNode(value);
+    return root;
+}
+
+BSTNode* deleteBSTIter(BSTNode* root, int value)
+{
+    BSTNode** link = &root;
+    while (*link != NULL && (*link)->val != value) {
+        if (value < (*link)->val) {
+            link = &(*link)->left;
+        } else {
+            link = &(*link)->right;
+        }
+    }
+    BSTNode* node = *link;
+    if (node == NULL) {
+        return root;
+        //the value is not in the tree
+    }
+    if (node->left == NULL) {
+        *link = node->right;
+    } else if (node->right == NULL) {
+        *link = node->left;
+    } else {
+        BSTNode** minLink = &node->right;
+        while ((*minLink)->left != NULL) {
+            minLink = &(*minLink)->left;
+        }
+        //the minimum node in the right subtree has no left child, so it can be unlinked directly
+        BSTNode* minNode = *minLink;
+        node->val = minNode->val;
+        *minLink = minNode->right;
+        node = minNode;
+    }
+    freeBSTNode(node);
+    return root;
+}
+
+BSTNode* searchBST(BSTNode* node, int value)
+{
+    while (node != NULL && node->val != value) {
+        node = value < node->val ? node->left : node->right;
+        //a search never changes the tree, so a plain loop is enough
+    }
+    return node;
+}
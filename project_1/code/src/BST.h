@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include "pool.h"
 
 typedef struct BSTNode {
     int val;
@@ -16,4 +17,13 @@ BSTNode* deleteBST(BSTNode* node, int value);
 
 int findMin(BSTNode* node);
 
+BSTNode* insertBSTIter(BSTNode* root, int value);
+BSTNode* deleteBSTIter(BSTNode* root, int value);
+BSTNode* searchBST(BSTNode* node, int value);  //the node holding value, NULL if it is not in the tree
+//iterative versions of the functions above, they never recurse so a degenerated tree cannot overflow the stack
+
+void setBSTPool(NodePool* pool);  //allocate nodes from the pool, NULL goes back to calloc/free
+BSTNode* allocBSTNode(int value);
+void freeBSTNode(BSTNode* node);
+
 #endif
\ No newline at end of file
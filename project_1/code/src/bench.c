@@ -0,0 +1,712 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "bench.h"
+#include "AVLTree.h"
+#include "AVLSet.h"
+#include "bulk.h"
+#include "BST.h"
+#include "splay.h"
+#include "splayTD.h"
+#include "compact.h"
+#include "snapshot.h"
+#include "AVLConcurrent.h"
+#include "typedtree.h"
+#include "treeimage.h"
+#include "workload.h"
+
+#define SET_REPEATS 10
+#define RANGE_QUERIES 100000
+#define RANGE_WALKS 100
+#define SNAPSHOT_LOOKUPS 1000000
+#define CONCURRENT_SECONDS 0.2
+#define CONCURRENT_MAX_THREADS 64
+#define KEYTYPE_REPEATS 100
+
+double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void report_result(FILE* file, const char* name, int n, const char* order_type, double seconds) {
+    fprintf(file, "%s,%d,%s,%f\n", name, n, order_type, seconds);
+    printf("Performance on %s with N=%d (%s): %f seconds\n", name, n, order_type, seconds);
+}
+
+void report_rate(FILE* file, const char* name, int n, const char* order_type, double opsPerSecond) {
+    fprintf(file, "%s,%d,%s,%f\n", name, n, order_type, opsPerSecond);
+    printf("Throughput of %s with N=%d (%s): %.0f ops/sec\n", name, n, order_type, opsPerSecond);
+}
+
+void report_bytes(FILE* file, const char* name, int n, const char* order_type, double bytesPerKey) {
+    fprintf(file, "%s,%d,%s,%f\n", name, n, order_type, bytesPerKey);
+    printf("Memory of %s with N=%d (%s): %.2f bytes per key\n", name, n, order_type, bytesPerKey);
+}
+
+void report_per_op(FILE* file, const char* name, int n, const char* order_type, double perOp, const char* what) {
+    fprintf(file, "%s,%d,%s,%f\n", name, n, order_type, perOp);
+    printf("Cost of %s with N=%d (%s): %.2f %s per operation\n", name, n, order_type, perOp, what);
+}
+
+// The keys of the data set at even positions form set A, the ones at positions divisible by 3 form set B
+void bench_set_ops(const int* values, int n, const char* order_type, FILE* file, int threads) {
+    int* keysA = (int*)malloc(sizeof(int) * (n / 2 + 1));
+    int* keysB = (int*)malloc(sizeof(int) * (n / 3 + 1));
+    if (keysA == NULL || keysB == NULL) {
+        perror("Memory allocation failed");
+        free(keysA);
+        free(keysB);
+        return;
+    }
+    int na = 0, nb = 0;
+    for (int i = 0; i < n; i++) {
+        if (i % 2 == 0) keysA[na++] = values[i];
+        if (i % 3 == 0) keysB[nb++] = values[i];
+    }
+
+    const char* opNames[3] = { "union", "intersect", "difference" };
+    char name[48];
+    for (int op = 0; op < 3; op++) {
+        double baseline = 0, sequential = 0, parallel = 0;
+        for (int repeat = 0; repeat < SET_REPEATS; repeat++) {
+            // the baseline: a lookup and at most one single-key insert or delete per key of B
+            AVLNode* a = buildAVL(keysA, na);
+            AVLNode* result = op == 1 ? NULL : a;
+            double start = wall_seconds();
+            for (int i = 0; i < nb; i++) {
+                int present = searchAVL(op == 1 ? a : result, keysB[i]) != NULL;
+                if (op == 0 && !present) {
+                    result = insertAVLIter(result, keysB[i]);
+                } else if (op == 1 && present) {
+                    result = insertAVLIter(result, keysB[i]);
+                } else if (op == 2 && present) {
+                    result = deleteAVLIter(result, keysB[i]);
+                }
+            }
+            baseline += wall_seconds() - start;
+            if (op == 1) destroyAVL(a);
+            destroyAVL(result);
+
+            for (int mode = 0; mode < 2; mode++) {
+                a = buildAVL(keysA, na);
+                AVLNode* b = buildAVL(keysB, nb);
+                start = wall_seconds();
+                if (op == 0) result = mode ? unionAVLPar(a, b, threads) : unionAVL(a, b);
+                else if (op == 1) result = mode ? intersectAVLPar(a, b, threads) : intersectAVL(a, b);
+                else result = mode ? differenceAVLPar(a, b, threads) : differenceAVL(a, b);
+                if (mode) parallel += wall_seconds() - start;
+                else sequential += wall_seconds() - start;
+                destroyAVL(result);
+            }
+        }
+        snprintf(name, sizeof(name), "AVL-%s-inserts", opNames[op]);
+        report_result(file, name, n, order_type, baseline);
+        snprintf(name, sizeof(name), "AVL-%s", opNames[op]);
+        report_result(file, name, n, order_type, sequential);
+        snprintf(name, sizeof(name), "AVL-%s-par%d", opNames[op], threads);
+        report_result(file, name, n, order_type, parallel);
+    }
+
+    free(keysA);
+    free(keysB);
+}
+
+// The pointer-based nodes are reported by their size alone, malloc adds its own header on top of that
+// (the --arena pool does not); the compact layout is measured as the whole node array after inserting all n keys
+void bench_layout_bytes(const int* values, int n, const char* order_type, FILE* file) {
+    report_bytes(file, "BST-bytes-per-key", n, order_type, (double)sizeof(BSTNode));
+    report_bytes(file, "AVL-bytes-per-key", n, order_type, (double)sizeof(AVLNode));
+    report_bytes(file, "Splay-bytes-per-key", n, order_type, (double)sizeof(SplayNode));
+    report_bytes(file, "SplayTD-bytes-per-key", n, order_type, (double)sizeof(TDSplayNode));
+
+    CompactTree tree;
+    compactInit(&tree, n);
+    for (int i = 0; i < n; i++) {
+        compactInsertAVL(&tree, values[i]);
+    }
+    report_bytes(file, "compact-bytes-per-key", n, order_type, (double)compactBytes(&tree) / n);
+    compactDestroy(&tree);
+}
+
+// The in-order walk answers a range count the way it had to be done before the subtree sizes
+static int walk_count(AVLNode* node, int lo, int hi) {
+    if (node == NULL) return 0;
+    int count = 0;
+    if (lo < node->val) count += walk_count(node->left, lo, hi);
+    if (lo <= node->val && node->val <= hi) count++;
+    if (node->val < hi) count += walk_count(node->right, lo, hi);
+    return count;
+}
+
+static void free_splay_tree(SplayNode* node) {
+    if (node == NULL) return;
+    free_splay_tree(node->left);
+    free_splay_tree(node->right);
+    freenode(node);
+}
+
+void bench_range_count(const int* values, int n, const char* order_type, FILE* file) {
+    int* lo = (int*)malloc(sizeof(int) * RANGE_QUERIES);
+    int* hi = (int*)malloc(sizeof(int) * RANGE_QUERIES);
+    if (lo == NULL || hi == NULL) {
+        perror("Memory allocation failed");
+        free(lo);
+        free(hi);
+        return;
+    }
+    srand(12345);
+    for (int i = 0; i < RANGE_QUERIES; i++) {
+        lo[i] = values[rand() % n];
+        hi[i] = lo[i] + rand() % (n / 10 + 1);
+    }
+
+    AVLNode* avl = buildAVL(values, n);
+    SplayNode* splayRoot = NULL;
+    for (int i = 0; i < n; i++) {
+        SplayNode* node = createnode(values[i]);
+        splayRoot = splay(node, insert(node, splayRoot));
+    }
+
+    long long avlTotal = 0, splayTotal = 0, walkTotal = 0, expected = 0;
+    double start = wall_seconds();
+    for (int i = 0; i < RANGE_QUERIES; i++) {
+        avlTotal += countRange(avl, lo[i], hi[i]);
+    }
+    report_rate(file, "AVL-countRange", n, order_type, RANGE_QUERIES / (wall_seconds() - start));
+
+    start = wall_seconds();
+    for (int i = 0; i < RANGE_QUERIES; i++) {
+        splayTotal += countRangeSplay(lo[i], hi[i], splayRoot);
+    }
+    report_rate(file, "Splay-countRange", n, order_type, RANGE_QUERIES / (wall_seconds() - start));
+
+    start = wall_seconds();
+    for (int i = 0; i < RANGE_WALKS; i++) {
+        walkTotal += walk_count(avl, lo[i], hi[i]);
+    }
+    report_rate(file, "AVL-inorder-walk", n, order_type, RANGE_WALKS / (wall_seconds() - start));
+
+    for (int i = 0; i < RANGE_WALKS; i++) {
+        expected += countRange(avl, lo[i], hi[i]);
+    }
+    if (avlTotal != splayTotal || walkTotal != expected) {
+        fprintf(stderr, "Error: range counts of AVL and Splay disagree.\n");
+    }
+
+    destroyAVL(avl);
+    free_splay_tree(splayRoot);
+    free(lo);
+    free(hi);
+}
+
+void bench_snapshot(const int* values, int n, const char* order_type, FILE* file) {
+    int* lookups = (int*)malloc(sizeof(int) * SNAPSHOT_LOOKUPS);
+    if (lookups == NULL) {
+        perror("Memory allocation failed");
+        return;
+    }
+    // about one lookup in ten misses
+    srand(12345);
+    for (int i = 0; i < SNAPSHOT_LOOKUPS; i++) {
+        lookups[i] = i % 10 == 0 ? -1 - rand() % n : values[rand() % n];
+    }
+
+    AVLNode* avl = buildAVL(values, n);
+    long long liveHits = 0, eytzingerHits = 0, vebHits = 0;
+    double start = wall_seconds();
+    for (int i = 0; i < SNAPSHOT_LOOKUPS; i++) {
+        liveHits += searchAVL(avl, lookups[i]) != NULL;
+    }
+    report_rate(file, "AVL-live-lookup", n, order_type, SNAPSHOT_LOOKUPS / (wall_seconds() - start));
+
+    const char* layoutNames[2] = { "eytzinger", "veb" };
+    char name[48];
+    for (int layout = SNAPSHOT_EYTZINGER; layout <= SNAPSHOT_VEB; layout++) {
+        start = wall_seconds();
+        Snapshot* snapshot = freezeAVL(avl, layout);
+        snprintf(name, sizeof(name), "AVL-freeze-%s", layoutNames[layout]);
+        report_result(file, name, n, order_type, wall_seconds() - start);
+        if (snapshot == NULL) {
+            fprintf(stderr, "Error: could not freeze the AVL tree.\n");
+            break;
+        }
+
+        long long hits = 0;
+        start = wall_seconds();
+        for (int i = 0; i < SNAPSHOT_LOOKUPS; i++) {
+            hits += snapshotContains(snapshot, lookups[i]);
+        }
+        snprintf(name, sizeof(name), "snapshot-%s-lookup", layoutNames[layout]);
+        report_rate(file, name, n, order_type, SNAPSHOT_LOOKUPS / (wall_seconds() - start));
+        if (layout == SNAPSHOT_EYTZINGER) eytzingerHits = hits;
+        else vebHits = hits;
+        freeSnapshot(snapshot);
+    }
+    if (liveHits != eytzingerHits || liveHits != vebHits) {
+        fprintf(stderr, "Error: the snapshots and the live tree disagree.\n");
+    }
+
+    destroyAVL(avl);
+    free(lookups);
+}
+
+// One reader thread of --concurrent, either on the RCU tree or on a plain AVL tree behind a rwlock
+typedef struct ReaderTask {
+    ConcurrentAVL* tree;
+    pthread_rwlock_t* lock;
+    AVLNode** root;
+    const int* values;
+    int n;
+    int reader;
+    atomic_int* stop;
+    long long lookups;
+    long long hits;
+} ReaderTask;
+
+static unsigned long long next_key(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void* rcu_reader(void* arg) {
+    ReaderTask* task = (ReaderTask*)arg;
+    unsigned long long state = 0x9E3779B97F4A7C15ULL * (task->reader + 1);
+    long long lookups = 0, hits = 0;
+    while (!atomic_load_explicit(task->stop, memory_order_relaxed)) {
+        hits += cavlContains(task->tree, task->reader, task->values[next_key(&state) % task->n]);
+        lookups++;
+    }
+    task->lookups = lookups;
+    task->hits = hits;
+    return NULL;
+}
+
+static void* rwlock_reader(void* arg) {
+    ReaderTask* task = (ReaderTask*)arg;
+    unsigned long long state = 0x9E3779B97F4A7C15ULL * (task->reader + 1);
+    long long lookups = 0, hits = 0;
+    while (!atomic_load_explicit(task->stop, memory_order_relaxed)) {
+        int key = task->values[next_key(&state) % task->n];
+        pthread_rwlock_rdlock(task->lock);
+        hits += searchAVL(*task->root, key) != NULL;
+        pthread_rwlock_unlock(task->lock);
+        lookups++;
+    }
+    task->lookups = lookups;
+    task->hits = hits;
+    return NULL;
+}
+
+// Lookups per second of 1, 2, 4, ..., 64 reader threads while one writer keeps inserting and deleting,
+// on the RCU tree against a plain AVL tree behind a rwlock; the writer's updates per second are reported too
+void bench_concurrent(const int* values, int n, const char* order_type, FILE* file) {
+    ReaderTask* tasks = (ReaderTask*)malloc(sizeof(ReaderTask) * CONCURRENT_MAX_THREADS);
+    pthread_t* readers = (pthread_t*)malloc(sizeof(pthread_t) * CONCURRENT_MAX_THREADS);
+    char* present = (char*)malloc(n);
+    if (tasks == NULL || readers == NULL || present == NULL) {
+        perror("Memory allocation failed");
+        free(tasks);
+        free(readers);
+        free(present);
+        return;
+    }
+
+    char name[48];
+    for (int useRcu = 1; useRcu >= 0; useRcu--) {
+        for (int threadCount = 1; threadCount <= CONCURRENT_MAX_THREADS; threadCount *= 2) {
+            ConcurrentAVL tree;
+            pthread_rwlock_t lock;
+            AVLNode* root = buildAVL(values, n);
+            atomic_int stop;
+            atomic_init(&stop, 0);
+            memset(present, 1, n);
+            if (useRcu) {
+                cavlInit(&tree, root);
+            } else {
+                pthread_rwlockattr_t attr;
+                pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+                pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+                // glibc prefers readers by default, and a stream of readers would starve the writer forever
+#endif
+                pthread_rwlock_init(&lock, &attr);
+                pthread_rwlockattr_destroy(&attr);
+            }
+
+            int started = 0;
+            for (int t = 0; t < threadCount; t++) {
+                tasks[t].tree = &tree;
+                tasks[t].lock = &lock;
+                tasks[t].root = &root;
+                tasks[t].values = values;
+                tasks[t].n = n;
+                tasks[t].reader = t;
+                tasks[t].stop = &stop;
+                if (pthread_create(&readers[t], NULL, useRcu ? rcu_reader : rwlock_reader, &tasks[t]) != 0) break;
+                started++;
+            }
+
+            // the writer runs on this thread and flips random keys between present and absent
+            unsigned long long state = 0x2545F4914F6CDD1DULL;
+            long long updates = 0;
+            double start = wall_seconds(), elapsed;
+            do {
+                int i = (int)(next_key(&state) % n);
+                if (useRcu) {
+                    if (present[i]) cavlDelete(&tree, values[i]);
+                    else cavlInsert(&tree, values[i]);
+                } else {
+                    pthread_rwlock_wrlock(&lock);
+                    root = present[i] ? deleteAVLIter(root, values[i]) : insertAVLIter(root, values[i]);
+                    pthread_rwlock_unlock(&lock);
+                }
+                present[i] = !present[i];
+                updates++;
+                elapsed = wall_seconds() - start;
+            } while (elapsed < CONCURRENT_SECONDS);
+            atomic_store(&stop, 1);
+
+            long long lookups = 0;
+            for (int t = 0; t < started; t++) {
+                pthread_join(readers[t], NULL);
+                lookups += tasks[t].lookups;
+            }
+            elapsed = wall_seconds() - start;
+            // the readers stop a little after the writer, so their rate uses the full time span
+
+            snprintf(name, sizeof(name), "AVL-%s-read-%d", useRcu ? "rcu" : "rwlock", started);
+            report_rate(file, name, n, order_type, lookups / elapsed);
+            snprintf(name, sizeof(name), "AVL-%s-write-%d", useRcu ? "rcu" : "rwlock", started);
+            report_rate(file, name, n, order_type, updates / elapsed);
+
+            if (useRcu) {
+                cavlDestroy(&tree);
+            } else {
+                pthread_rwlock_destroy(&lock);
+                destroyAVL(root);
+            }
+            if (started < threadCount) {
+                fprintf(stderr, "Error: could only start %d reader threads.\n", started);
+                break;
+            }
+        }
+    }
+
+    free(tasks);
+    free(readers);
+    free(present);
+}
+
+// The trees of --keytypes, generated from typedtree.h
+DEFINE_TYPED_TREES(Int32, int32_t, compareInt32)
+DEFINE_TYPED_TREES(Int64, int64_t, compareInt64)
+DEFINE_TYPED_TREES(Str, const char*, compareString)
+DEFINE_TYPED_TREES(StrPrefix, StrKey, compareStrKey)
+
+// Inserts every key, looks every key up and deletes them in the delete order, KEYTYPE_REPEATS times,
+// like TEST_INSERT_DELETE; a lookup that misses means the generated tree is broken
+#define TIME_TYPED_TREE(label, P, T, insertKeys, lookup_found, deleteKeys) {                 \
+    long long found = 0;                                                                   \
+    double start = wall_seconds();                                                         \
+    for (int repeat = 0; repeat < KEYTYPE_REPEATS; repeat++) {                             \
+        P##T##Node* root = NULL;                                                           \
+        for (int i = 0; i < n; i++) root = P##Insert##T(root, (insertKeys)[i]);            \
+        for (int i = 0; i < n; i++) found += lookup_found(P, T, root, (insertKeys)[i]);    \
+        for (int i = 0; i < n; i++) root = P##Delete##T(root, (deleteKeys)[i]);            \
+        P##Free##T(root);                                                                  \
+    }                                                                                      \
+    report_result(file, label, n, order_type, wall_seconds() - start);                     \
+    if (found != (long long)n * KEYTYPE_REPEATS) {                                         \
+        fprintf(stderr, "Error: %s lost keys.\n", label);                                  \
+    }                                                                                      \
+}
+
+#define FOUND_SEARCH(P, T, root, key) (P##Search##T(root, key) != NULL)
+#define FOUND_SPLAY(P, T, root, key) (root = P##SearchSplay(root, key, &hit), hit)
+
+#define TIME_TYPED_TREES(suffix, P, insertKeys, deleteKeys) {                              \
+    int hit;                                                                               \
+    TIME_TYPED_TREE("BST-" suffix, P, BST, insertKeys, FOUND_SEARCH, deleteKeys);          \
+    TIME_TYPED_TREE("AVL-" suffix, P, AVL, insertKeys, FOUND_SEARCH, deleteKeys);          \
+    TIME_TYPED_TREE("SplayTD-" suffix, P, Splay, insertKeys, FOUND_SPLAY, deleteKeys);     \
+}
+
+#define KEY_CHARS 11
+
+// The int32 keys are the data set itself; the int64 and string keys are spread over their whole range
+// in the same order, so inc / dec / rand keep their meaning: int64 keys are multiples of INT64_MAX / (n + 1),
+// string keys are the 10-digit decimal form of the same spread over 32 bits, which leaves the 8-byte prefix
+// distinct for most pairs of keys but still needs the full compare for close ones
+void bench_key_types(const int* values, const int* deletes, int n, const char* order_type, FILE* file) {
+    int32_t* ints = (int32_t*)malloc(sizeof(int32_t) * n * 2);
+    int64_t* longs = (int64_t*)malloc(sizeof(int64_t) * n * 2);
+    char* chars = (char*)malloc((size_t)KEY_CHARS * n * 2);
+    const char** strs = (const char**)malloc(sizeof(const char*) * n * 2);
+    StrKey* prefixed = (StrKey*)malloc(sizeof(StrKey) * n * 2);
+    if (ints == NULL || longs == NULL || chars == NULL || strs == NULL || prefixed == NULL) {
+        perror("Memory allocation failed");
+        free(ints);
+        free(longs);
+        free(chars);
+        free(strs);
+        free(prefixed);
+        return;
+    }
+
+    int64_t longStep = INT64_MAX / ((int64_t)n + 1);
+    uint32_t strStep = UINT32_MAX / ((uint32_t)n + 1);
+    for (int i = 0; i < n * 2; i++) {
+        int v = i < n ? values[i] : deletes[i - n];
+        ints[i] = v;
+        longs[i] = (int64_t)v * longStep;
+        snprintf(chars + (size_t)KEY_CHARS * i, KEY_CHARS, "%010u", (uint32_t)v * strStep);
+        strs[i] = chars + (size_t)KEY_CHARS * i;
+        prefixed[i] = makeStrKey(strs[i]);
+    }
+    // the second half of every array holds the keys in the delete order
+
+    TIME_TYPED_TREES("int32", Int32, ints, ints + n);
+    TIME_TYPED_TREES("int64", Int64, longs, longs + n);
+    TIME_TYPED_TREES("str", Str, strs, strs + n);
+    TIME_TYPED_TREES("str-prefix", StrPrefix, prefixed, prefixed + n);
+
+    free(ints);
+    free(longs);
+    free(chars);
+    free(strs);
+    free(prefixed);
+}
+
+#define PERSISTENT_SNAPSHOTS 1000000
+#define PERSISTENT_COPIES 20
+
+// The baseline of --persistent: a point-in-time view by copying every node
+static AVLNode* copy_tree(AVLNode* node) {
+    if (node == NULL) return NULL;
+    AVLNode* copy = allocAVLNode(node->val);
+    *copy = *node;
+    copy->left = copy_tree(node->left);
+    copy->right = copy_tree(node->right);
+    return copy;
+}
+
+// Snapshots of the persistent AVL tree against full copies: the time to take one, and the memory a snapshot
+// keeps alive after 1%, 10% and 100% of n updates to the live version (a full copy always costs a whole tree)
+void bench_persistent(const int* values, int n, const char* order_type, FILE* file) {
+    NodePool* savedPool = getAVLPool();
+    NodePool pool;
+    poolInit(&pool, sizeof(AVLNode), 0);
+    setAVLPool(&pool);
+    // the pool counts the live nodes of all versions together
+
+    AVLNode* root = NULL;
+    double start = wall_seconds();
+    for (int i = 0; i < n; i++) {
+        AVLNode* next = insertAVLPersistent(root, values[i]);
+        releaseAVL(root);
+        root = next;
+    }
+    report_result(file, "AVL-persistent-inserts", n, order_type, wall_seconds() - start);
+
+    start = wall_seconds();
+    for (int i = 0; i < PERSISTENT_SNAPSHOTS; i++) {
+        releaseAVL(retainAVL(root));
+    }
+    report_rate(file, "AVL-persistent-snapshot", n, order_type, PERSISTENT_SNAPSHOTS / (wall_seconds() - start));
+    start = wall_seconds();
+    for (int i = 0; i < PERSISTENT_COPIES; i++) {
+        AVLNode* copy = copy_tree(root);
+        destroyAVL(copy);
+    }
+    report_rate(file, "AVL-full-copy", n, order_type, PERSISTENT_COPIES / (wall_seconds() - start));
+    report_bytes(file, "AVL-full-copy-bytes", n, order_type, (double)sizeof(AVLNode));
+
+    // the live version flips random keys of the data set while a snapshot holds the version before
+    char* present = (char*)malloc(n);
+    if (present != NULL) {
+        const int percents[3] = { 1, 10, 100 };
+        unsigned long long state = 0x9E3779B97F4A7C15ULL;
+        char name[48];
+        memset(present, 1, n);
+        for (int p = 0; p < 3; p++) {
+            AVLNode* snapshot = retainAVL(root);
+            long long updates = (long long)n * percents[p] / 100;
+            start = wall_seconds();
+            for (long long u = 0; u < updates; u++) {
+                int i = (int)(next_key(&state) % n);
+                AVLNode* next = present[i] ? deleteAVLPersistent(root, values[i]) : insertAVLPersistent(root, values[i]);
+                releaseAVL(root);
+                root = next;
+                present[i] = !present[i];
+            }
+            double elapsed = wall_seconds() - start;
+            snprintf(name, sizeof(name), "AVL-persistent-update-%d%%", percents[p]);
+            report_rate(file, name, n, order_type, updates / elapsed);
+            snprintf(name, sizeof(name), "AVL-snapshot-bytes-%d%%", percents[p]);
+            report_bytes(file, name, n, order_type, (double)(pool.liveNodes - getSize(root)) * sizeof(AVLNode) / n);
+            releaseAVL(snapshot);
+            if (pool.liveNodes != (size_t)getSize(root)) {
+                fprintf(stderr, "Error: releasing the snapshot left %zu nodes behind.\n", pool.liveNodes - getSize(root));
+            }
+        }
+        free(present);
+    }
+
+    releaseAVL(root);
+    setAVLPool(savedPool);
+    poolDestroy(&pool);
+}
+
+// Frees a BST of any depth without recursion: a left child is rotated up until the root has none
+static void free_bst_tree(BSTNode* node) {
+    while (node != NULL) {
+        if (node->left != NULL) {
+            BSTNode* left = node->left;
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            BSTNode* right = node->right;
+            freeBSTNode(node);
+            node = right;
+        }
+    }
+}
+
+// Every key of the data set must be found in the mapped image and in the rebuilt tree
+static int image_holds_keys(const TreeImage* image, const int* values, int n) {
+    for (int i = 0; i < n; i++) {
+        if (!compactSearch(&image->tree, values[i])) return 0;
+    }
+    return 1;
+}
+
+// Restarting from a saved tree against building it again: n inserts, mapping the image (searchable right away),
+// and rebuilding the pointer-based tree from the image in one O(n) pass
+void bench_image(const int* values, int n, const char* order_type, FILE* file) {
+    char avlPath[128], bstPath[128];
+    snprintf(avlPath, sizeof(avlPath), "test_data/tree_%d_%s_avl.img", n, order_type);
+    snprintf(bstPath, sizeof(bstPath), "test_data/tree_%d_%s_bst.img", n, order_type);
+
+    double start = wall_seconds();
+    AVLNode* avl = NULL;
+    for (int i = 0; i < n; i++) {
+        avl = insertAVLIter(avl, values[i]);
+    }
+    report_result(file, "AVL-restart-inserts", n, order_type, wall_seconds() - start);
+    start = wall_seconds();
+    BSTNode* bst = NULL;
+    for (int i = 0; i < n; i++) {
+        bst = insertBSTIter(bst, values[i]);
+    }
+    report_result(file, "BST-restart-inserts", n, order_type, wall_seconds() - start);
+
+    start = wall_seconds();
+    int saved = saveAVLImage(avl, avlPath);
+    report_result(file, "AVL-image-save", n, order_type, wall_seconds() - start);
+    start = wall_seconds();
+    saved = saveBSTImage(bst, bstPath) && saved;
+    report_result(file, "BST-image-save", n, order_type, wall_seconds() - start);
+    if (!saved) {
+        destroyAVL(avl);
+        free_bst_tree(bst);
+        return;
+    }
+
+    TreeImage image;
+    start = wall_seconds();
+    if (mapTreeImage(&image, avlPath)) {
+        report_result(file, "AVL-restart-mmap", n, order_type, wall_seconds() - start);
+        report_bytes(file, "AVL-image-bytes", n, order_type, (double)image.mappingBytes / n);
+        if (!image_holds_keys(&image, values, n)) {
+            fprintf(stderr, "Error: the mapped AVL image lost keys.\n");
+        }
+        start = wall_seconds();
+        AVLNode* rebuilt = rebuildAVL(&image);
+        report_result(file, "AVL-restart-rebuild", n, order_type, wall_seconds() - start);
+        if (getSize(rebuilt) != getSize(avl) || getHeight(rebuilt) != getHeight(avl)) {
+            fprintf(stderr, "Error: the rebuilt AVL tree differs from the saved one.\n");
+        }
+        destroyAVL(rebuilt);
+        unmapTreeImage(&image);
+    }
+
+    start = wall_seconds();
+    if (mapTreeImage(&image, bstPath)) {
+        report_result(file, "BST-restart-mmap", n, order_type, wall_seconds() - start);
+        report_bytes(file, "BST-image-bytes", n, order_type, (double)image.mappingBytes / n);
+        if (!image_holds_keys(&image, values, n)) {
+            fprintf(stderr, "Error: the mapped BST image lost keys.\n");
+        }
+        start = wall_seconds();
+        BSTNode* rebuilt = rebuildBST(&image);
+        report_result(file, "BST-restart-rebuild", n, order_type, wall_seconds() - start);
+        for (int i = 0; i < n; i++) {
+            if (searchBST(rebuilt, values[i]) == NULL) {
+                fprintf(stderr, "Error: the rebuilt BST lost key %d.\n", values[i]);
+                break;
+            }
+        }
+        free_bst_tree(rebuilt);
+        unmapTreeImage(&image);
+    }
+
+    remove(avlPath);
+    remove(bstPath);
+    destroyAVL(avl);
+    free_bst_tree(bst);
+}
+
+#define SPLAY_POLICY_READS 1000000
+
+// Zipfian reads on a splay tree holding the whole data set, once per search policy: ops/sec and
+// the nodes the rotations write per read, which is the write traffic a policy saves
+void bench_splay_policies(const int* values, int n, const char* order_type, FILE* file, const char* policies, const char* dist_text) {
+    WorkloadMix mix;
+    KeyDistribution dist;
+    Workload work;
+    parseMix("100/0/0", &mix);
+    parseDistribution(dist_text ? dist_text : "zipf", &dist);
+    if (!makeWorkload(&work, values, n, &mix, &dist, SPLAY_POLICY_READS)) {
+        perror("Memory allocation failed");
+        return;
+    }
+
+    char list[256], name[96];
+    snprintf(list, sizeof(list), "%s", policies);
+    for (char* text = strtok(list, ","); text != NULL; text = strtok(NULL, ",")) {
+        SplayPolicy policy;
+        parseSplayPolicy(text, &policy);
+        SplayNode* root = NULL;
+        for (int i = 0; i < n; i++) {
+            SplayNode* node = createnode(values[i]);
+            root = splay(node, insert(node, root));
+        }
+
+        long long hits = 0;
+        double start = wall_seconds();
+        for (int i = 0; i < work.count; i++) {
+            int found;
+            root = searchSplayPolicy(work.ops[i].key, root, &policy, &found);
+            hits += found;
+        }
+        double elapsed = wall_seconds() - start;
+
+        snprintf(name, sizeof(name), "Splay-%s-%s", policy.name, dist.name);
+        report_rate(file, name, n, order_type, work.count / elapsed);
+        snprintf(name, sizeof(name), "Splay-%s-%s-writes", policy.name, dist.name);
+        report_per_op(file, name, n, order_type, (double)policy.written / work.count, "nodes written");
+        if (hits != work.count) {
+            fprintf(stderr, "Error: splay policy %s lost keys.\n", policy.name);
+        }
+        free_splay_tree(root);
+    }
+    freeWorkload(&work);
+}
@@ -0,0 +1,48 @@
+#ifndef BENCH_HEADER
+#define BENCH_HEADER
+
+#include <stdio.h>
+
+// The extra benchmark modes of tree_analyzer
+// Every mode writes "<name>,<N>,<order_type>,<value>" lines to the results file, like TEST_INSERT_DELETE does
+
+double wall_seconds(void);  // monotonic wall clock, clock() adds up the CPU time of all threads
+void report_result(FILE* file, const char* name, int n, const char* order_type, double seconds);
+void report_rate(FILE* file, const char* name, int n, const char* order_type, double opsPerSecond);
+void report_bytes(FILE* file, const char* name, int n, const char* order_type, double bytesPerKey);
+void report_per_op(FILE* file, const char* name, int n, const char* order_type, double perOp, const char* what);
+
+// --setops: union / intersection / difference of two AVL key sets taken from the data set,
+// with join/split sequentially and on `threads` threads, against inserting one set into the other
+void bench_set_ops(const int* values, int n, const char* order_type, FILE* file, int threads);
+
+// --compact: bytes per key of the pointer-based nodes and of the shared index-based layout
+void bench_layout_bytes(const int* values, int n, const char* order_type, FILE* file);
+
+// --rank: range-count queries per second with the subtree sizes of AVL and Splay, against an in-order walk
+void bench_range_count(const int* values, int n, const char* order_type, FILE* file);
+
+// --snapshot: lookups per second on the frozen Eytzinger and vEB snapshots against the live AVL tree
+void bench_snapshot(const int* values, int n, const char* order_type, FILE* file);
+
+// --concurrent: lookups per second of 1 to 64 reader threads next to one writer,
+// on the RCU AVL tree with lock-free readers against an AVL tree behind a rwlock
+void bench_concurrent(const int* values, int n, const char* order_type, FILE* file);
+
+// --keytypes: insert/lookup/delete times of BST, AVL and top-down Splay generated for int32, int64
+// and string keys, the strings once with plain strcmp and once with the 8-byte prefix cached in the node
+void bench_key_types(const int* values, const int* deletes, int n, const char* order_type, FILE* file);
+
+// --persistent: snapshots of the path-copying AVL tree against full copies, how fast they are taken
+// and how many bytes per key a snapshot keeps alive while the live version is updated
+void bench_persistent(const int* values, int n, const char* order_type, FILE* file);
+
+// --image: restarting AVL and BST from a tree image saved to test_data/, mapped in place or rebuilt in O(n),
+// against inserting the n keys again; the images are removed afterwards
+void bench_image(const int* values, int n, const char* order_type, FILE* file);
+
+// --splay-policy: reads drawn from dist_text (default zipf) on a splay tree with each of the search policies
+// of splay.h in the comma-separated list, ops/sec and nodes written per read
+void bench_splay_policies(const int* values, int n, const char* order_type, FILE* file, const char* policies, const char* dist_text);
+
+#endif
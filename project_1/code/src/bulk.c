@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bulk.h"
+
+static int compareInt(const void* a, const void* b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+int* sortedKeys(const int* values, int n, int* owned)
+{
+    int increasing = 1, decreasing = 1;
+    for (int i = 1; i < n && (increasing || decreasing); i ++) {
+        if (values[i - 1] > values[i]) {
+            increasing = 0;
+        } else if (values[i - 1] < values[i]) {
+            decreasing = 0;
+        }
+    }
+    //one pass tells us whether the input is already ordered
+    if (increasing) {
+        *owned = 0;
+        return (int*)values;
+    }
+    int* keys = (int*)malloc(sizeof(int) * (n > 0 ? n : 1));
+    if (keys == NULL) {
+        *owned = 0;
+        return NULL;
+    }
+    *owned = 1;
+    if (decreasing) {
+        for (int i = 0; i < n; i ++) {
+            keys[i] = values[n - 1 - i];
+        }
+    } else {
+        for (int i = 0; i < n; i ++) {
+            keys[i] = values[i];
+        }
+        qsort(keys, n, sizeof(int), compareInt);
+        //fall back to sort-then-build
+    }
+    return keys;
+}
+
+static AVLNode* buildAVLRange(const int* keys, int lo, int hi)
+{
+    //the middle element of keys[lo, hi) becomes the root, the two halves become the subtrees
+    if (lo >= hi) {
+        return NULL;
+    }
+    int mid = lo + (hi - lo) / 2;
+    AVLNode* node = allocAVLNode(keys[mid]);
+    node->left = buildAVLRange(keys, lo, mid);
+    node->right = buildAVLRange(keys, mid + 1, hi);
+    updateAVL(node);
+    //both halves differ in size by at most one, so every node is balanced without any rotation
+    return node;
+}
+
+AVLNode* buildAVL(const int* values, int n)
+{
+    int owned;
+    int* keys = sortedKeys(values, n, &owned);
+    if (keys == NULL) {
+        return NULL;
+    }
+    AVLNode* root = buildAVLRange(keys, 0, n);
+    if (owned) {
+        free(keys);
+    }
+    return root;
+}
+
+static BSTNode* buildBSTRange(const int* keys, int lo, int hi)
+{
+    if (lo >= hi) {
+        return NULL;
+    }
+    int mid = lo + (hi - lo) / 2;
+    BSTNode* node = allocBSTNode(keys[mid]);
+    node->left = buildBSTRange(keys, lo, mid);
+    node->right = buildBSTRange(keys, mid + 1, hi);
+    return node;
+}
+
+BSTNode* buildBST(const int* values, int n)
+{
+    int owned;
+    int* keys = sortedKeys(values, n, &owned);
+    if (keys == NULL) {
+        return NULL;
+    }
+    int m = n;
+    int hasDuplicates = 0;
+    for (int i = 1; i < n && !hasDuplicates; i ++) {
+        hasDuplicates = keys[i] == keys[i - 1];
+    }
+    if (hasDuplicates) {
+        if (!owned) {
+            //the input is sorted but we need our own copy to squeeze the duplicates out
+            int* copy = (int*)malloc(sizeof(int) * n);
+            if (copy == NULL) {
+                return NULL;
+            }
+            for (int i = 0; i < n; i ++) {
+                copy[i] = keys[i];
+            }
+            keys = copy;
+            owned = 1;
+        }
+        m = 1;
+        for (int i = 1; i < n; i ++) {
+            if (keys[i] != keys[m - 1]) {
+                keys[m++] = keys[i];
+            }
+        }
+    }
+    BSTNode* root = buildBSTRange(keys, 0, m);
+    if (owned) {
+        free(keys);
+    }
+    return root;
+}
@@ -0,0 +1,18 @@
+#ifndef BULK_HEADER
+#define BULK_HEADER
+
+#include "AVLTree.h"
+#include "BST.h"
+
+//bulk loading: build a perfectly balanced tree from an array in one go instead of n inserts
+//sorted input (increasing or decreasing) is detected in one pass and built in O(n),
+//any other input is copied and sorted first
+
+int* sortedKeys(const int* values, int n, int* owned);
+//returns the values in increasing order, either values itself or a sorted copy
+//*owned is set to 1 when the caller has to free() the returned copy
+
+AVLNode* buildAVL(const int* values, int n);  //duplicates are kept, just like insertAVL() does
+BSTNode* buildBST(const int* values, int n);  //duplicates are dropped, just like insertBST() does
+
+#endif
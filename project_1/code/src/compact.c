@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "compact.h"
+
+#define LEFT(t, i) ((t)->nodes[i].left & COMPACT_INDEX_MASK)
+#define RIGHT(t, i) ((t)->nodes[i].right)
+#define VAL(t, i) ((t)->nodes[i].val)
+#define BAL(t, i) ((int)((t)->nodes[i].left >> 30) - 1)
+#define BAL_ZERO (1u << 30)
+//the node array may move whenever a node is allocated,
+//so we only ever keep indices, never pointers into it, across a call that can allocate
+
+static void setLeft(CompactTree* t, uint32_t i, uint32_t child)
+{
+    t->nodes[i].left = (t->nodes[i].left & ~COMPACT_INDEX_MASK) | child;
+}
+
+static void setBal(CompactTree* t, uint32_t i, int bal)
+{
+    t->nodes[i].left = (t->nodes[i].left & COMPACT_INDEX_MASK) | ((uint32_t)(bal + 1) << 30);
+}
+
+void compactInit(CompactTree* tree, uint32_t capacity)
+{
+    tree->nodes = NULL;
+    tree->capacity = 0;
+    if (capacity > 0) {
+        tree->nodes = (CompactNode*)malloc(sizeof(CompactNode) * ((size_t)capacity + 1));
+        if (tree->nodes != NULL) {
+            tree->capacity = capacity + 1;
+        }
+    }
+    compactClear(tree);
+}
+
+void compactClear(CompactTree* tree)
+{
+    tree->used = 1;
+    //slot 0 stands for "no child"
+    tree->freeList = COMPACT_NIL;
+    tree->root = COMPACT_NIL;
+    tree->count = 0;
+}
+
+void compactDestroy(CompactTree* tree)
+{
+    free(tree->nodes);
+    tree->nodes = NULL;
+    tree->capacity = 0;
+    compactClear(tree);
+}
+
+size_t compactBytes(const CompactTree* tree)
+{
+    return sizeof(CompactNode) * (size_t)tree->capacity;
+}
+
+static uint32_t newNode(CompactTree* t, int value)
+{
+    uint32_t i;
+    if (t->freeList != COMPACT_NIL) {
+        i = t->freeList;
+        t->freeList = RIGHT(t, i);
+    } else {
+        if (t->used >= t->capacity) {
+            uint32_t capacity = t->capacity < 16 ? 16 : t->capacity * 2;
+            if (capacity > COMPACT_MAX_NODES || capacity < t->capacity) {
+                capacity = COMPACT_MAX_NODES;
+            }
+            if (capacity == t->capacity) {
+                fprintf(stderr, "compact tree: too many nodes\n");
+                exit(1);
+            }
+            CompactNode* nodes = (CompactNode*)realloc(t->nodes, sizeof(CompactNode) * (size_t)capacity);
+            if (nodes == NULL) {
+                perror("compact tree");
+                exit(1);
+            }
+            t->nodes = nodes;
+            t->capacity = capacity;
+        }
+        i = t->used++;
+    }
+    t->nodes[i].val = value;
+    t->nodes[i].left = BAL_ZERO;
+    t->nodes[i].right = COMPACT_NIL;
+    t->count++;
+    return i;
+}
+
+static void freeNode(CompactTree* t, uint32_t i)
+{
+    t->nodes[i].right = t->freeList;
+    t->freeList = i;
+    t->count--;
+}
+
+int compactSearch(const CompactTree* tree, int value)
+{
+    uint32_t i = tree->root;
+    while (i != COMPACT_NIL && VAL(tree, i) != value) {
+        i = value < VAL(tree, i) ? LEFT(tree, i) : RIGHT(tree, i);
+    }
+    return i != COMPACT_NIL;
+}
+
+/* ---------- BST ---------- */
+
+void compactInsertBST(CompactTree* tree, int value)
+{
+    uint32_t parent = COMPACT_NIL;
+    uint32_t i = tree->root;
+    while (i != COMPACT_NIL) {
+        if (value == VAL(tree, i)) {
+            return;
+            //a duplicated value is ignored, just like insertBST() does
+        }
+        parent = i;
+        i = value < VAL(tree, i) ? LEFT(tree, i) : RIGHT(tree, i);
+    }
+    uint32_t node = newNode(tree, value);
+    if (parent == COMPACT_NIL) {
+        tree->root = node;
+    } else if (value < VAL(tree, parent)) {
+        setLeft(tree, parent, node);
+    } else {
+        tree->nodes[parent].right = node;
+    }
+}
+
+void compactDeleteBST(CompactTree* tree, int value)
+{
+    uint32_t parent = COMPACT_NIL;
+    uint32_t i = tree->root;
+    while (i != COMPACT_NIL && VAL(tree, i) != value) {
+        parent = i;
+        i = value < VAL(tree, i) ? LEFT(tree, i) : RIGHT(tree, i);
+    }
+    if (i == COMPACT_NIL) {
+        return;
+    }
+    if (LEFT(tree, i) != COMPACT_NIL && RIGHT(tree, i) != COMPACT_NIL) {
+        //copy the minimum of the right subtree into i and unlink that node instead
+        uint32_t minParent = i;
+        uint32_t min = RIGHT(tree, i);
+        while (LEFT(tree, min) != COMPACT_NIL) {
+            minParent = min;
+            min = LEFT(tree, min);
+        }
+        VAL(tree, i) = VAL(tree, min);
+        if (minParent == i) {
+            tree->nodes[i].right = RIGHT(tree, min);
+        } else {
+            setLeft(tree, minParent, RIGHT(tree, min));
+        }
+        freeNode(tree, min);
+        return;
+    }
+    uint32_t child = LEFT(tree, i) != COMPACT_NIL ? LEFT(tree, i) : RIGHT(tree, i);
+    if (parent == COMPACT_NIL) {
+        tree->root = child;
+    } else if (LEFT(tree, parent) == i) {
+        setLeft(tree, parent, child);
+    } else {
+        tree->nodes[parent].right = child;
+    }
+    freeNode(tree, i);
+}
+
+/* ---------- AVL with 2-bit balance factors ---------- */
+
+static uint32_t fixRightHeavy(CompactTree* t, uint32_t x, int* shorter)
+{
+    //the right subtree of x is two levels higher than the left one
+    uint32_t y = RIGHT(t, x);
+    int yBal = BAL(t, y);
+    if (yBal >= 0) {
+        //RR case, a single left rotation
+        t->nodes[x].right = LEFT(t, y);
+        setLeft(t, y, x);
+        if (yBal == 0) {
+            //only possible after a deletion, the height stays the same
+            setBal(t, x, 1);
+            setBal(t, y, -1);
+            *shorter = 0;
+        } else {
+            setBal(t, x, 0);
+            setBal(t, y, 0);
+            *shorter = 1;
+        }
+        return y;
+    }
+    //RL case, z = y->left becomes the root of the subtree
+    uint32_t z = LEFT(t, y);
+    int zBal = BAL(t, z);
+    t->nodes[x].right = LEFT(t, z);
+    setLeft(t, y, RIGHT(t, z));
+    setLeft(t, z, x);
+    t->nodes[z].right = y;
+    setBal(t, x, zBal == 1 ? -1 : 0);
+    setBal(t, y, zBal == -1 ? 1 : 0);
+    setBal(t, z, 0);
+    *shorter = 1;
+    return z;
+}
+
+static uint32_t fixLeftHeavy(CompactTree* t, uint32_t x, int* shorter)
+{
+    uint32_t y = LEFT(t, x);
+    int yBal = BAL(t, y);
+    if (yBal <= 0) {
+        //LL case, a single right rotation
+        setLeft(t, x, RIGHT(t, y));
+        t->nodes[y].right = x;
+        if (yBal == 0) {
+            setBal(t, x, -1);
+            setBal(t, y, 1);
+            *shorter = 0;
+        } else {
+            setBal(t, x, 0);
+            setBal(t, y, 0);
+            *shorter = 1;
+        }
+        return y;
+    }
+    //LR case
+    uint32_t z = RIGHT(t, y);
+    int zBal = BAL(t, z);
+    setLeft(t, x, RIGHT(t, z));
+    t->nodes[y].right = LEFT(t, z);
+    setLeft(t, z, y);
+    t->nodes[z].right = x;
+    setBal(t, x, zBal == -1 ? 1 : 0);
+    setBal(t, y, zBal == 1 ? -1 : 0);
+    setBal(t, z, 0);
+    *shorter = 1;
+    return z;
+}
+
+static uint32_t avlInsert(CompactTree* t, uint32_t node, int value, int* grew)
+{
+    if (node == COMPACT_NIL) {
+        *grew = 1;
+        return newNode(t, value);
+    }
+    int unused;
+    if (value < VAL(t, node)) {
+        uint32_t child = avlInsert(t, LEFT(t, node), value, grew);
+        setLeft(t, node, child);
+        if (*grew) {
+            int bal = BAL(t, node);
+            if (bal == 1) {
+                setBal(t, node, 0);
+                *grew = 0;
+            } else if (bal == 0) {
+                setBal(t, node, -1);
+            } else {
+                node = fixLeftHeavy(t, node, &unused);
+                *grew = 0;
+            }
+        }
+    } else {
+        //equal values go to the right, just like insertAVL() does
+        uint32_t child = avlInsert(t, RIGHT(t, node), value, grew);
+        t->nodes[node].right = child;
+        if (*grew) {
+            int bal = BAL(t, node);
+            if (bal == -1) {
+                setBal(t, node, 0);
+                *grew = 0;
+            } else if (bal == 0) {
+                setBal(t, node, 1);
+            } else {
+                node = fixRightHeavy(t, node, &unused);
+                *grew = 0;
+            }
+        }
+    }
+    return node;
+}
+
+static uint32_t leftShrunk(CompactTree* t, uint32_t node, int* shorter)
+{
+    int bal = BAL(t, node);
+    if (bal == -1) {
+        setBal(t, node, 0);
+        *shorter = 1;
+    } else if (bal == 0) {
+        setBal(t, node, 1);
+        *shorter = 0;
+    } else {
+        node = fixRightHeavy(t, node, shorter);
+    }
+    return node;
+}
+
+static uint32_t rightShrunk(CompactTree* t, uint32_t node, int* shorter)
+{
+    int bal = BAL(t, node);
+    if (bal == 1) {
+        setBal(t, node, 0);
+        *shorter = 1;
+    } else if (bal == 0) {
+        setBal(t, node, -1);
+        *shorter = 0;
+    } else {
+        node = fixLeftHeavy(t, node, shorter);
+    }
+    return node;
+}
+
+static uint32_t avlDelete(CompactTree* t, uint32_t node, int value, int* shorter)
+{
+    if (node == COMPACT_NIL) {
+        *shorter = 0;
+        return COMPACT_NIL;
+    }
+    if (value < VAL(t, node)) {
+        setLeft(t, node, avlDelete(t, LEFT(t, node), value, shorter));
+        if (*shorter) {
+            node = leftShrunk(t, node, shorter);
+        }
+    } else if (value > VAL(t, node)) {
+        t->nodes[node].right = avlDelete(t, RIGHT(t, node), value, shorter);
+        if (*shorter) {
+            node = rightShrunk(t, node, shorter);
+        }
+    } else if (LEFT(t, node) == COMPACT_NIL || RIGHT(t, node) == COMPACT_NIL) {
+        uint32_t child = LEFT(t, node) != COMPACT_NIL ? LEFT(t, node) : RIGHT(t, node);
+        freeNode(t, node);
+        *shorter = 1;
+        return child;
+    } else {
+        //replace the value with the minimum of the right subtree and delete that one instead
+        uint32_t min = RIGHT(t, node);
+        while (LEFT(t, min) != COMPACT_NIL) {
+            min = LEFT(t, min);
+        }
+        VAL(t, node) = VAL(t, min);
+        t->nodes[node].right = avlDelete(t, RIGHT(t, node), VAL(t, min), shorter);
+        if (*shorter) {
+            node = rightShrunk(t, node, shorter);
+        }
+    }
+    return node;
+}
+
+void compactInsertAVL(CompactTree* tree, int value)
+{
+    int grew;
+    tree->root = avlInsert(tree, tree->root, value, &grew);
+}
+
+void compactDeleteAVL(CompactTree* tree, int value)
+{
+    int shorter;
+    tree->root = avlDelete(tree, tree->root, value, &shorter);
+}
+
+/* ---------- top-down splay ---------- */
+
+static uint32_t splayIndex(CompactTree* t, uint32_t root, int k)
+{
+    //the same algorithm as splayTD(), with the two side trees kept as (first, last) index pairs
+    if (root == COMPACT_NIL) {
+        return COMPACT_NIL;
+    }
+    uint32_t leftFirst = COMPACT_NIL, leftLast = COMPACT_NIL;
+    uint32_t rightFirst = COMPACT_NIL, rightLast = COMPACT_NIL;
+    uint32_t y;
+    while (1) {
+        if (k < VAL(t, root)) {
+            if (LEFT(t, root) == COMPACT_NIL) {
+                break;
+            }
+            if (k < VAL(t, LEFT(t, root))) {
+                y = LEFT(t, root);
+                setLeft(t, root, RIGHT(t, y));
+                t->nodes[y].right = root;
+                root = y;
+                if (LEFT(t, root) == COMPACT_NIL) {
+                    break;
+                }
+            }
+            if (rightLast == COMPACT_NIL) {
+                rightFirst = root;
+            } else {
+                setLeft(t, rightLast, root);
+            }
+            rightLast = root;
+            root = LEFT(t, root);
+        } else if (k > VAL(t, root)) {
+            if (RIGHT(t, root) == COMPACT_NIL) {
+                break;
+            }
+            if (k > VAL(t, RIGHT(t, root))) {
+                y = RIGHT(t, root);
+                t->nodes[root].right = LEFT(t, y);
+                setLeft(t, y, root);
+                root = y;
+                if (RIGHT(t, root) == COMPACT_NIL) {
+                    break;
+                }
+            }
+            if (leftLast == COMPACT_NIL) {
+                leftFirst = root;
+            } else {
+                t->nodes[leftLast].right = root;
+            }
+            leftLast = root;
+            root = RIGHT(t, root);
+        } else {
+            break;
+        }
+    }
+    if (leftLast == COMPACT_NIL) {
+        leftFirst = LEFT(t, root);
+    } else {
+        t->nodes[leftLast].right = LEFT(t, root);
+    }
+    if (rightLast == COMPACT_NIL) {
+        rightFirst = RIGHT(t, root);
+    } else {
+        setLeft(t, rightLast, RIGHT(t, root));
+    }
+    setLeft(t, root, leftFirst);
+    t->nodes[root].right = rightFirst;
+    return root;
+}
+
+int compactSearchSplay(CompactTree* tree, int value)
+{
+    tree->root = splayIndex(tree, tree->root, value);
+    return tree->root != COMPACT_NIL && VAL(tree, tree->root) == value;
+}
+
+void compactInsertSplay(CompactTree* tree, int value)
+{
+    uint32_t root = splayIndex(tree, tree->root, value);
+    tree->root = root;
+    if (root != COMPACT_NIL && VAL(tree, root) == value) {
+        return;
+    }
+    uint32_t node = newNode(tree, value);
+    if (root != COMPACT_NIL) {
+        if (value < VAL(tree, root)) {
+            setLeft(tree, node, LEFT(tree, root));
+            tree->nodes[node].right = root;
+            setLeft(tree, root, COMPACT_NIL);
+        } else {
+            tree->nodes[node].right = RIGHT(tree, root);
+            setLeft(tree, node, root);
+            tree->nodes[root].right = COMPACT_NIL;
+        }
+    }
+    tree->root = node;
+}
+
+void compactDeleteSplay(CompactTree* tree, int value)
+{
+    uint32_t root = splayIndex(tree, tree->root, value);
+    tree->root = root;
+    if (root == COMPACT_NIL || VAL(tree, root) != value) {
+        return;
+    }
+    uint32_t newRoot;
+    if (LEFT(tree, root) == COMPACT_NIL) {
+        newRoot = RIGHT(tree, root);
+    } else {
+        newRoot = splayIndex(tree, LEFT(tree, root), value);
+        tree->nodes[newRoot].right = RIGHT(tree, root);
+    }
+    freeNode(tree, root);
+    tree->root = newRoot;
+}
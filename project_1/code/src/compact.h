@@ -0,0 +1,50 @@
+#ifndef COMPACT_HEADER
+#define COMPACT_HEADER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+//index-based storage shared by the BST, AVL and splay trees
+//all the nodes live in one growing array and the children are 32-bit indices into it,
+//so a node is 12 bytes instead of the 24-32 bytes of the pointer-based nodes
+//index 0 is never used for a node and means "no child"
+//the top 2 bits of left hold the AVL balance factor (right height - left height + 1)
+
+#define COMPACT_NIL 0
+#define COMPACT_INDEX_MASK 0x3FFFFFFFu
+#define COMPACT_MAX_NODES COMPACT_INDEX_MASK
+
+typedef struct CompactNode {
+    int val;
+    uint32_t left;    //left child index in the low 30 bits, balance in the top 2 bits
+    uint32_t right;
+} CompactNode;
+
+typedef struct CompactTree {
+    CompactNode* nodes;
+    uint32_t capacity;  //number of slots in nodes
+    uint32_t used;      //slots [1, used) have been handed out at least once
+    uint32_t freeList;  //released slots, linked through their right field
+    uint32_t root;
+    uint32_t count;     //number of keys in the tree
+} CompactTree;
+
+void compactInit(CompactTree* tree, uint32_t capacity);  //capacity is only a hint, the array grows on demand
+void compactClear(CompactTree* tree);    //removes every key in O(1), the array is kept
+void compactDestroy(CompactTree* tree);
+size_t compactBytes(const CompactTree* tree);  //memory held by the node array
+
+int compactSearch(const CompactTree* tree, int value);  //plain descent, works for all three trees
+
+void compactInsertBST(CompactTree* tree, int value);
+void compactDeleteBST(CompactTree* tree, int value);
+
+void compactInsertAVL(CompactTree* tree, int value);
+void compactDeleteAVL(CompactTree* tree, int value);
+
+void compactInsertSplay(CompactTree* tree, int value);   //top-down splay, the nodes need no parent link
+void compactDeleteSplay(CompactTree* tree, int value);
+int compactSearchSplay(CompactTree* tree, int value);    //splays the last node on the search path to the root
+
+#endif
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dataset.h"
+
+static int hostIsLittleEndian(void)
+{
+    const uint16_t one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+static void storeLE(unsigned char* out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint64_t loadLE(const unsigned char* in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+int writeDatasetHeader(FILE* file, const DatasetInfo* info)
+{
+    unsigned char header[DATASET_HEADER_BYTES];
+    memset(header, 0, sizeof(header));
+    memcpy(header, DATASET_MAGIC, 8);
+    storeLE(header + 8, DATASET_VERSION, 4);
+    storeLE(header + 12, (uint64_t)info->valueBytes, 4);
+    storeLE(header + 16, info->count, 8);
+    storeLE(header + 24, info->seed, 8);
+    memcpy(header + 32, info->order, strlen(info->order));//at most DATASET_ORDER_BYTES, random_generator checks
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+//the text format of random_generator: the count, then the values separated by spaces
+static int openText(Dataset* data, const char* path, int n)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Failed to open input file");
+        return 0;
+    }
+    int count = 0;
+    if (fscanf(file, "%d", &count) == 1 && n == 0) {
+        n = count;
+    }
+    if (count <= 0 || count < n) {
+        fprintf(stderr, "Error: %s does not hold %d integers.\n", path, n);
+        fclose(file);
+        return 0;
+    }
+    data->owned = (int*)malloc(sizeof(int) * n);
+    if (data->owned == NULL) {
+        perror("Memory allocation failed");
+        fclose(file);
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        if (fscanf(file, "%d", data->owned + i) != 1) {
+            fprintf(stderr, "Error: %s does not hold %d integers.\n", path, n);
+            fclose(file);
+            free(data->owned);
+            data->owned = NULL;
+            return 0;
+        }
+    }
+    fclose(file);
+    data->values = data->owned;
+    data->count = n;
+    return 1;
+}
+
+//int32 values on a little-endian host are used in place, everything else is decoded into a copy
+static int mapBinary(Dataset* data, int fd, size_t fileBytes, const char* path, int n)
+{
+    void* mapping = mmap(NULL, fileBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("Failed to map input file");
+        return 0;
+    }
+    int valueBytes = data->info.valueBytes;
+    const unsigned char* raw = (const unsigned char*)mapping + DATASET_HEADER_BYTES;
+    if (valueBytes == (int)sizeof(int) && hostIsLittleEndian()) {
+        madvise(mapping, fileBytes, MADV_WILLNEED);//the benchmarks walk the values many times
+        data->mapping = mapping;
+        data->mappingBytes = fileBytes;
+        data->values = (const int*)raw;//the header is 48 bytes, so the values stay 16-byte aligned
+        data->count = n;
+        return 1;
+    }
+
+    data->owned = (int*)malloc(sizeof(int) * n);
+    if (data->owned == NULL) {
+        perror("Memory allocation failed");
+        munmap(mapping, fileBytes);
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        uint64_t bits = loadLE(raw + (size_t)i * valueBytes, valueBytes);
+        int64_t value = valueBytes == 4 ? (int64_t)(int32_t)(uint32_t)bits : (int64_t)bits;
+        if (value < INT_MIN || value > INT_MAX) {
+            fprintf(stderr, "Error: value %lld in %s does not fit the int trees.\n", (long long)value, path);
+            free(data->owned);
+            data->owned = NULL;
+            munmap(mapping, fileBytes);
+            return 0;
+        }
+        data->owned[i] = (int)value;
+    }
+    munmap(mapping, fileBytes);
+    data->values = data->owned;
+    data->count = n;
+    return 1;
+}
+
+int openDataset(Dataset* data, const char* path, int n)
+{
+    memset(data, 0, sizeof(*data));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open input file");
+        return 0;
+    }
+    struct stat st;
+    unsigned char header[DATASET_HEADER_BYTES];
+    if (fstat(fd, &st) != 0 || st.st_size < DATASET_HEADER_BYTES
+        || pread(fd, header, DATASET_HEADER_BYTES, 0) != DATASET_HEADER_BYTES
+        || memcmp(header, DATASET_MAGIC, 8) != 0) {
+        close(fd);
+        return openText(data, path, n);
+    }
+
+    data->binary = 1;
+    data->info.valueBytes = (int)loadLE(header + 12, 4);
+    data->info.count = loadLE(header + 16, 8);
+    data->info.seed = loadLE(header + 24, 8);
+    memcpy(data->info.order, header + 32, DATASET_ORDER_BYTES);
+    data->info.order[DATASET_ORDER_BYTES] = '\0';
+    if (loadLE(header + 8, 4) != DATASET_VERSION || (data->info.valueBytes != 4 && data->info.valueBytes != 8)) {
+        fprintf(stderr, "Error: %s is not a version %d data set.\n", path, DATASET_VERSION);
+        close(fd);
+        return 0;
+    }
+    if (n == 0 && data->info.count <= INT_MAX) {
+        n = (int)data->info.count;
+    }
+    if (n == 0 || data->info.count < (uint64_t)n
+        || (uint64_t)st.st_size < DATASET_HEADER_BYTES + data->info.count * data->info.valueBytes) {
+        fprintf(stderr, "Error: %s does not hold %d integers.\n", path, n);
+        close(fd);
+        return 0;
+    }
+    int ok = mapBinary(data, fd, (size_t)st.st_size, path, n);
+    close(fd);//the mapping stays valid without the descriptor
+    return ok;
+}
+
+void closeDataset(Dataset* data)
+{
+    if (data->mapping) {
+        munmap(data->mapping, data->mappingBytes);
+    }
+    free(data->owned);
+    memset(data, 0, sizeof(*data));
+}
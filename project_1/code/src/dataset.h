@@ -0,0 +1,50 @@
+#ifndef DATASET_HEADER
+#define DATASET_HEADER
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// The binary data set format written by random_generator --binary and read by tree_analyzer
+// a 48-byte header, all fields little-endian:
+//   0  "TREEDATA"
+//   8  uint32 version (1)
+//  12  uint32 bytes per value (4 or 8)
+//  16  uint64 number of values
+//  24  uint64 seed of the shuffle
+//  32  char[16] order type, padded with zeros
+// followed right away by the values as little-endian int32 or int64
+
+#define DATASET_MAGIC "TREEDATA"
+#define DATASET_VERSION 1
+#define DATASET_HEADER_BYTES 48
+#define DATASET_ORDER_BYTES 16
+
+typedef struct DatasetInfo {
+    int valueBytes;                  // 4 or 8
+    uint64_t count;
+    uint64_t seed;
+    char order[DATASET_ORDER_BYTES + 1];
+} DatasetInfo;
+
+// A loaded data set: values points into the mapped file when it holds int32 values on a little-endian host,
+// otherwise into a decoded copy
+typedef struct Dataset {
+    const int* values;
+    int count;
+    int binary;                      // 1 if it came from the binary format
+    DatasetInfo info;                // only set for the binary format
+    void* mapping;                   // the mapped file, NULL if nothing is mapped
+    size_t mappingBytes;
+    int* owned;                      // the decoded copy, NULL if values is zero-copy
+} Dataset;
+
+int writeDatasetHeader(FILE* file, const DatasetInfo* info);  // 1 on success
+
+// Loads the first n values of path, in the binary format if the file starts with the magic, in the text format
+// of random_generator otherwise; n = 0 loads all of them
+// returns 1 on success and prints the reason to stderr on failure
+int openDataset(Dataset* data, const char* path, int n);
+void closeDataset(Dataset* data);
+
+#endif
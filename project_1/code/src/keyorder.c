@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "keyorder.h"
+
+#define DEFAULT_SEED 0x2025ADULL
+#define STREAM_VALUES 1
+#define STREAM_DELETES 2
+#define STREAM_LOOKUPS 3
+#define STREAM_POPULARITY 4
+//every stream is seeded from the seed and its own number, so adding a stream never changes the others
+
+static uint64_t splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void seedKeyRng(KeyRng* rng, uint64_t seed)
+{
+    //the state of xoshiro must not be all zero, splitmix64 spreads any seed over all four words
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+static uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t nextKeyRng(KeyRng* rng)
+{
+    uint64_t* s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+uint32_t keyRngBelow(KeyRng* rng, uint32_t bound)
+{
+    //Lemire's multiply-and-reject: the top 32 bits of x * bound, redrawn in the rare biased cases
+    uint64_t m = (nextKeyRng(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (nextKeyRng(rng) >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+double keyRngUniform(KeyRng* rng)
+{
+    return (nextKeyRng(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void seedStream(KeyRng* rng, uint64_t seed, int stream)
+{
+    seedKeyRng(rng, (seed ? seed : DEFAULT_SEED) * 0x100000001B3ULL + (uint64_t)stream);
+}
+
+int parseNamed(const char* text, const char* name, double* param)
+{
+    size_t len = strlen(name);
+    char tail;
+    if (strncmp(text, name, len) != 0) {
+        return 0;
+    }
+    if (text[len] == '\0') {
+        return 1;
+    }
+    return text[len] == ':' && sscanf(text + len + 1, "%lf%c", param, &tail) == 1;
+}
+
+int parseKeyOrder(const char* text, KeyOrder* order)
+{
+    order->param = 0;
+    if (strcmp(text, "inc") == 0) {
+        order->kind = ORDER_INC;
+    } else if (strcmp(text, "dec") == 0) {
+        order->kind = ORDER_DEC;
+    } else if (strcmp(text, "rand") == 0) {
+        order->kind = ORDER_RAND;
+    } else if ((order->param = 0.05, parseNamed(text, "nearly", &order->param))) {
+        order->kind = ORDER_NEARLY;
+        if (order->param < 0 || order->param > 1) {
+            return 0;
+        }
+    } else if ((order->param = 0.99, parseNamed(text, "zipf", &order->param))) {
+        order->kind = ORDER_ZIPF;
+        if (order->param <= 0) {
+            return 0;
+        }
+    } else if ((order->param = 8, parseNamed(text, "sawtooth", &order->param))) {
+        order->kind = ORDER_SAWTOOTH;
+        if (order->param < 1 || order->param != floor(order->param)) {
+            return 0;
+        }
+    } else if ((order->param = 0, parseNamed(text, "clustered", &order->param))) {
+        order->kind = ORDER_CLUSTERED;
+        if (order->param < 0 || order->param != floor(order->param)) {
+            return 0;
+        }
+    } else {
+        return 0;
+    }
+    snprintf(order->name, sizeof(order->name), "%s", text);
+    return 1;
+}
+
+static void shuffleKeys(int* keys, int n, KeyRng* rng)
+{
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)keyRngBelow(rng, (uint32_t)i + 1);
+        int temp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = temp;
+    }
+}
+
+typedef struct Priority {
+    double key;
+    int value;
+} Priority;
+
+static int comparePriority(const void* a, const void* b)
+{
+    double x = ((const Priority*)a)->key, y = ((const Priority*)b)->key;
+    return (x > y) - (x < y);
+}
+
+//sampling without replacement with weight rank^-s (coldFirst: rank^s), by sorting exponential arrival times;
+//popular[r] is the key of popularity rank r + 1
+static int zipfOrder(int* keys, int n, double s, const int* popular, int coldFirst, KeyRng* rng)
+{
+    Priority* order = (Priority*)malloc(sizeof(Priority) * (size_t)n);
+    if (order == NULL) {
+        return 0;
+    }
+    for (int r = 0; r < n; r++) {
+        double weight = pow(r + 1, coldFirst ? s : -s);
+        order[r].key = -log(1.0 - keyRngUniform(rng)) / weight;
+        order[r].value = popular[r];
+    }
+    qsort(order, (size_t)n, sizeof(Priority), comparePriority);
+    for (int i = 0; i < n; i++) {
+        keys[i] = order[i].value;
+    }
+    free(order);
+    return 1;
+}
+
+//the non-zipf orders, written into keys; returns 0 if there is not enough memory
+static int shapeKeys(int* keys, int n, const KeyOrder* order, KeyRng* rng)
+{
+    int i = 0;
+    if (order->kind == ORDER_SAWTOOTH) {
+        int teeth = order->param < n ? (int)order->param : n;
+        for (int t = 1; t <= teeth; t++) {
+            for (long long key = t; key <= n; key += teeth) {
+                keys[i++] = (int)key;
+            }
+        }
+        return 1;
+    }
+    if (order->kind == ORDER_CLUSTERED) {
+        int size = order->param > 0 ? (int)order->param : (int)ceil(sqrt((double)n));
+        if (size > n) {
+            size = n;
+        }
+        int runs = (n + size - 1) / size;
+        int* first = (int*)malloc(sizeof(int) * (size_t)runs);   //the first key of every run, in run order
+        if (first == NULL) {
+            return 0;
+        }
+        for (int r = 0; r < runs; r++) {
+            first[r] = r * size + 1;
+        }
+        shuffleKeys(first, runs, rng);
+        for (int r = 0; r < runs; r++) {
+            int start = first[r];
+            int end = start + size - 1 < n ? start + size - 1 : n;
+            for (int key = start; key <= end; key++) {
+                keys[i++] = key;
+            }
+        }
+        free(first);
+        return 1;
+    }
+
+    for (i = 0; i < n; i++) {
+        keys[i] = order->kind == ORDER_DEC ? n - i : i + 1;
+    }
+    if (order->kind == ORDER_RAND) {
+        shuffleKeys(keys, n, rng);
+    } else if (order->kind == ORDER_NEARLY) {
+        //each position is picked with probability p, the keys at the picked positions are shuffled among them
+        int* picked = (int*)malloc(sizeof(int) * (size_t)n);
+        int count = 0;
+        if (picked == NULL) {
+            return 0;
+        }
+        for (i = 0; i < n; i++) {
+            if (keyRngUniform(rng) < order->param) {
+                picked[count++] = i;
+            }
+        }
+        for (int j = count - 1; j > 0; j--) {
+            int k = (int)keyRngBelow(rng, (uint32_t)j + 1);
+            int temp = keys[picked[j]];
+            keys[picked[j]] = keys[picked[k]];
+            keys[picked[k]] = temp;
+        }
+        free(picked);
+    }
+    return 1;
+}
+
+//rejection-inversion sampling of a Zipf rank in 1..n (Hoermann and Derflinger), O(1) time and memory
+typedef struct ZipfSampler {
+    int n;
+    double s, hX1, hN, cut;
+} ZipfSampler;
+
+static double helper1(double x)   //log(1 + x) / x
+{
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x / 2;
+}
+
+static double helper2(double x)   //(exp(x) - 1) / x
+{
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x / 2;
+}
+
+static double zipfH(const ZipfSampler* z, double x)
+{
+    return exp(-z->s * log(x));
+}
+
+static double zipfHIntegral(const ZipfSampler* z, double x)
+{
+    double logX = log(x);
+    return helper2((1 - z->s) * logX) * logX;
+}
+
+static double zipfHIntegralInverse(const ZipfSampler* z, double x)
+{
+    double t = x * (1 - z->s);
+    if (t < -1) {
+        t = -1;
+    }
+    return exp(helper1(t) * x);
+}
+
+static void zipfInit(ZipfSampler* z, int n, double s)
+{
+    z->n = n;
+    z->s = s;
+    z->hX1 = zipfHIntegral(z, 1.5) - 1;
+    z->hN = zipfHIntegral(z, n + 0.5);
+    z->cut = 2 - zipfHIntegralInverse(z, zipfHIntegral(z, 2.5) - zipfH(z, 2));
+}
+
+static int zipfNext(const ZipfSampler* z, KeyRng* rng)
+{
+    while (1) {
+        double u = z->hN + keyRngUniform(rng) * (z->hX1 - z->hN);
+        double x = zipfHIntegralInverse(z, u);
+        int k = (int)(x + 0.5);
+        if (k < 1) {
+            k = 1;
+        } else if (k > z->n) {
+            k = z->n;
+        }
+        if (k - x <= z->cut || u >= zipfHIntegral(z, k + 0.5) - zipfH(z, k)) {
+            return k;
+        }
+    }
+}
+
+int generateKeyStreams(const KeyOrder* order, int n, uint64_t seed, int* values, int* deletes, int* lookups, int lookupCount)
+{
+    KeyRng rng;
+    int* popular = NULL;
+    if (order->kind == ORDER_ZIPF) {
+        //the popularity ranks are spread over the whole key range instead of sitting at one end of it
+        popular = (int*)malloc(sizeof(int) * (size_t)n);
+        if (popular == NULL) {
+            return 0;
+        }
+        for (int r = 0; r < n; r++) {
+            popular[r] = r + 1;
+        }
+        seedStream(&rng, seed, STREAM_POPULARITY);
+        shuffleKeys(popular, n, &rng);
+    }
+
+    int ok = 1;
+    seedStream(&rng, seed, STREAM_VALUES);
+    if (order->kind == ORDER_ZIPF) {
+        ok = zipfOrder(values, n, order->param, popular, 0, &rng);
+    } else {
+        ok = shapeKeys(values, n, order, &rng);
+    }
+
+    if (ok && deletes) {
+        seedStream(&rng, seed, STREAM_DELETES);
+        if (order->kind == ORDER_ZIPF) {
+            ok = zipfOrder(deletes, n, order->param, popular, 1, &rng);
+        } else if (order->kind == ORDER_DEC) {
+            for (int i = 0; i < n; i++) {
+                deletes[i] = i + 1;
+            }
+        } else {
+            ok = shapeKeys(deletes, n, order, &rng);
+        }
+    }
+
+    if (ok && lookups) {
+        seedStream(&rng, seed, STREAM_LOOKUPS);
+        if (order->kind == ORDER_ZIPF) {
+            ZipfSampler zipf;
+            zipfInit(&zipf, n, order->param);
+            for (int i = 0; i < lookupCount; i++) {
+                lookups[i] = popular[zipfNext(&zipf, &rng) - 1];
+            }
+        } else {
+            for (int i = 0; i < lookupCount; i++) {
+                lookups[i] = (int)keyRngBelow(&rng, (uint32_t)n) + 1;
+            }
+        }
+    }
+    free(popular);
+    return ok;
+}
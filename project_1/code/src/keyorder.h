@@ -0,0 +1,45 @@
+#ifndef KEYORDER_HEADER
+#define KEYORDER_HEADER
+
+#include <stdint.h>
+
+//the orders random_generator writes the keys 1..n in, and the delete and lookup streams that go with them
+//shared by random_generator and by tree_analyzer --sweep, so both produce the same data for the same seed
+
+#define ORDER_INC 0
+#define ORDER_DEC 1
+#define ORDER_RAND 2
+#define ORDER_NEARLY 3      //sorted, except that a fraction p of the keys is shuffled among their positions
+#define ORDER_ZIPF 4        //popular keys tend to come first, key popularity follows a Zipf law with exponent s
+#define ORDER_SAWTOOTH 5    //k ascending runs over the whole key range: 1, 1+k, 1+2k, ..., then 2, 2+k, ...
+#define ORDER_CLUSTERED 6   //runs of consecutive keys in random run order, like appends from many sources
+
+typedef struct KeyRng {
+    uint64_t s[4];   //xoshiro256**
+} KeyRng;
+
+typedef struct KeyOrder {
+    int kind;
+    double param;   //nearly: p, zipf: s, sawtooth: k, clustered: keys per run (0: sqrt(n))
+    char name[32];
+} KeyOrder;
+
+void seedKeyRng(KeyRng* rng, uint64_t seed);
+uint64_t nextKeyRng(KeyRng* rng);
+uint32_t keyRngBelow(KeyRng* rng, uint32_t bound);   //uniform in [0, bound) without modulo bias
+double keyRngUniform(KeyRng* rng);                   //uniform in [0, 1)
+
+int parseNamed(const char* text, const char* name, double* param);
+//"name" or "name:<number>", *param is left alone when the number is missing; also parses --splay-policy
+int parseKeyOrder(const char* text, KeyOrder* order);
+//"inc", "dec", "rand", "nearly[:p]", "zipf[:s]", "sawtooth[:k]" or "clustered[:size]", returns 0 if text is malformed
+
+int generateKeyStreams(const KeyOrder* order, int n, uint64_t seed, int* values, int* deletes, int* lookups, int lookupCount);
+//values gets 1..n in the given order, deletes the same keys in the order they are deleted and lookups
+//lookupCount keys to search for; deletes and lookups may be NULL, every stream has its own generator
+//the deletes come in a fresh order of the same kind, except that dec deletes in ascending order as
+//tree_analyzer always did and zipf deletes the least popular keys first;
+//lookups follow the key popularity for zipf and are uniform otherwise
+//returns 0 if there is not enough memory
+
+#endif
@@ -2,10 +2,78 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "BST.h"
 #include "AVLTree.h"
 #include "splay.h"
+#include "splayTD.h"
+#include "pool.h"
+#include "bulk.h"
+#include "bench.h"
+#include "compact.h"
+#include "BPlusTree.h"
+#include "workload.h"
+#include "measure.h"
+#include "treestats.h"
+#include "dataset.h"
+#include "keyorder.h"
+
+// Set by --arena: the trees take their nodes from a slab pool and are torn down with one poolReset()
+static int useArena = 0;
+static NodePool BSTpool, AVLpool, Splaypool, SplayTDpool;
+// Set by --iter: BST and AVL run on the iterative insert/delete engines
+static int useIter = 0;
+// Set by --bulk: also compare bulk loading against n single inserts
+static int useBulk = 0;
+// Set by --setops: also run the AVL set algebra benchmark on --threads threads
+static int useSetOps = 0;
+static int threads = 0;
+// Set by --compact: also run the three trees on the index-based layout and report bytes per key
+static int useCompact = 0;
+static CompactTree compactTree;
+// Set by --rank: also benchmark the order statistics
+static int useRank = 0;
+// Set by --snapshot: also compare lookups on frozen snapshots against the live AVL tree
+static int useSnapshot = 0;
+// Set by --workload: also run mixed read/insert/delete workloads with skewed keys,
+// --mix and --dist replace the default mixes and key distributions, --ops sets the length of a run
+static int useWorkload = 0;
+static const char* mixArg = NULL;
+static const char* distArg = NULL;
+static int workloadOps = 1000000;
+// Set by --concurrent: also measure lock-free AVL lookups from up to 64 threads next to a writer
+static int useConcurrent = 0;
+// Set by --lookups: also search the lookup stream random_generator --lookups wrote for this data set
+static int useLookups = 0;
+// Set by --persistent: also time O(1) snapshots of the path-copying AVL tree against full copies
+static int usePersistent = 0;
+// Set by --image: also time restarting AVL and BST from a saved tree image against n inserts
+static int useImage = 0;
+// Set by --splay-policy: also run Zipfian reads on Splay with each of these search policies
+static const char* splayPolicies = NULL;
+// Set by --keytypes: also time BST, AVL and Splay generated for int32, int64 and string keys
+static int useKeyTypes = 0;
+// Set by --latency: also time every single insert and delete, and sample the hardware counters per phase
+static int useLatency = 0;
+static LatencyHistogram insertLatency, deleteLatency;
+static PerfCounters insertPerf, deletePerf;
+static FILE *latencyCSV, *latencyJSON;
+// Set by --sweep: <N> and <order_type> are lists, the data sets are generated in memory and every tree
+// is timed sweepReps times after sweepWarmup untimed rounds; --trees picks the trees
+static int useSweep = 0;
+static int sweepWarmup = 1;
+static int sweepReps = 10;
+static const char* sweepTrees = "BST,AVL,Splay,SplayTD,BPT";
+static double* sweepSamples = NULL;
+// Number of reads that found their key, so that no search can be optimized away
+static long workloadHits = 0;
+
+// Name of a tree in the results file, e.g. "AVL", "AVL-iter" or "AVL-iter-arena"
+static const char* tree_label(char* buf, size_t size, const char* base, int hasIter) {
+    snprintf(buf, size, "%s%s%s", base, (useIter && hasIter) ? "-iter" : "", useArena ? "-arena" : "");
+    return buf;
+}
 
 // Macro to test insert and delete operations for a tree type
 // It now outputs directly to a single file in a standardized format
@@ -14,18 +82,115 @@
     for (int repeat = 0; repeat < 100; repeat++) { \
         root = NULL; \
         for (int i = 0; i < n; i++) { \
+            STATS_OP_BEGIN(); \
             root = insert_func(root, values_arr[i]); \
+            STATS_OP_END(); \
         } \
         for (int i = 0; i < n; i++) { \
+            STATS_OP_BEGIN(); \
             root = delete_func(root, delete_arr[i]); \
+            STATS_OP_END(); \
         } \
-        free_##tree_type(root); \
+        release_##tree_type(root); \
     } \
     clock_t end_time_##tree_type = clock(); \
     total_time = (double)(end_time_##tree_type - start_time_##tree_type) / CLOCKS_PER_SEC ; \
     fprintf(file, "%s,%d,%s,%f\n", tree_name_str, n, order_type, total_time); \
     printf("Performance on %s with N=%d (%s): %f seconds\n", tree_name_str, n, order_type, total_time);
 
+// Macro to time building a whole tree from values_arr in one call (used by --bulk)
+#define TEST_BUILD(tree_name_str, tree_type, root, build_func, values_arr, n, file, total_time) \
+    clock_t build_start_##tree_type = clock(); \
+    for (int repeat = 0; repeat < 100; repeat++) { \
+        root = build_func(values_arr, n); \
+        release_##tree_type(root); \
+    } \
+    clock_t build_end_##tree_type = clock(); \
+    total_time = (double)(build_end_##tree_type - build_start_##tree_type) / CLOCKS_PER_SEC ; \
+    fprintf(file, "%s,%d,%s,%f\n", tree_name_str, n, order_type, total_time); \
+    printf("Performance on %s with N=%d (%s): %f seconds\n", tree_name_str, n, order_type, total_time);
+
+// Macro to run a pre-generated workload on a tree type and report ops/sec (used by --workload)
+// The preload is not timed, the tree is torn down after the run
+#define TEST_WORKLOAD(tree_name_str, tree_type, root, insert_func, delete_func, search_func, work, file) \
+    { \
+        root = NULL; \
+        for (int i = 0; i < (work)->preloadCount; i++) { \
+            root = insert_func(root, (work)->preload[i]); \
+        } \
+        double start = wall_seconds(); \
+        for (int i = 0; i < (work)->count; i++) { \
+            const WorkloadOp* op = &(work)->ops[i]; \
+            if (op->type == OP_READ) root = search_func(root, op->key); \
+            else if (op->type == OP_INSERT) root = insert_func(root, op->key); \
+            else root = delete_func(root, op->key); \
+        } \
+        double elapsed = wall_seconds() - start; \
+        release_##tree_type(root); \
+        report_rate(file, tree_name_str, n, order_type, (work)->count / elapsed); \
+    }
+
+// Macro to time every insert and delete of a tree type on its own (used by --latency)
+// Repetition 0 only samples the hardware counters, so they do not count the clock reads;
+// it also warms up the caches and the allocator for the timed repetitions
+#define LATENCY_REPEATS 10
+#define TEST_LATENCY(tree_name_str, tree_type, root, insert_func, delete_func, values_arr, delete_arr, n) \
+    { \
+        latencyInit(&insertLatency); \
+        latencyInit(&deleteLatency); \
+        perfOpen(&insertPerf); \
+        perfOpen(&deletePerf); \
+        for (int repeat = 0; repeat <= LATENCY_REPEATS; repeat++) { \
+            root = NULL; \
+            if (repeat == 0) { \
+                perfStart(&insertPerf); \
+                for (int i = 0; i < n; i++) root = insert_func(root, values_arr[i]); \
+                perfStop(&insertPerf); \
+                perfStart(&deletePerf); \
+                for (int i = 0; i < n; i++) root = delete_func(root, delete_arr[i]); \
+                perfStop(&deletePerf); \
+            } else { \
+                uint64_t last = now_ns(); \
+                for (int i = 0; i < n; i++) { \
+                    root = insert_func(root, values_arr[i]); \
+                    uint64_t now = now_ns(); \
+                    latencyRecord(&insertLatency, now - last); \
+                    last = now; \
+                } \
+                last = now_ns(); \
+                for (int i = 0; i < n; i++) { \
+                    root = delete_func(root, delete_arr[i]); \
+                    uint64_t now = now_ns(); \
+                    latencyRecord(&deleteLatency, now - last); \
+                    last = now; \
+                } \
+            } \
+            release_##tree_type(root); \
+        } \
+        write_latency(tree_name_str, n, order_type, "insert", &insertLatency, &insertPerf); \
+        write_latency(tree_name_str, n, order_type, "delete", &deleteLatency, &deletePerf); \
+        perfClose(&insertPerf); \
+        perfClose(&deletePerf); \
+    }
+
+// Macro to time whole insert-all/delete-all rounds of a tree type one by one (used by --sweep)
+#define TEST_SWEEP(tree_name_str, tree_type, root, insert_func, delete_func, values_arr, delete_arr, n, file) \
+    { \
+        for (int repeat = 0; repeat < sweepWarmup + sweepReps; repeat++) { \
+            double start = wall_seconds(); \
+            root = NULL; \
+            for (int i = 0; i < n; i++) { \
+                root = insert_func(root, values_arr[i]); \
+            } \
+            for (int i = 0; i < n; i++) { \
+                root = delete_func(root, delete_arr[i]); \
+            } \
+            release_##tree_type(root); \
+            if (repeat >= sweepWarmup) sweepSamples[repeat - sweepWarmup] = wall_seconds() - start; \
+        } \
+        report_sweep(file, tree_name_str, n, order_type, sweepSamples, sweepReps); \
+    }
+
 // Helper function to free BST
 void free_BST(BSTNode* node) {
     if (node == NULL) return;
@@ -68,16 +233,517 @@ void free_Splay(SplayNode* node) {
     free(node);
 }
 
+// Tear a tree down after one repetition: either reset its pool in O(1) or walk it recursively
+void release_BST(BSTNode* node) {
+    if (useArena) poolReset(&BSTpool);
+    else free_BST(node);
+}
+
+void release_AVL(AVLNode* node) {
+    if (useArena) poolReset(&AVLpool);
+    else free_AVL(node);
+}
+
+void release_Splay(SplayNode* node) {
+    if (useArena) poolReset(&Splaypool);
+    else free_Splay(node);
+}
+
+
+// Top-down splay tree: wrappers with the (root, value) signature the macro expects
+TDSplayNode* insert_SplayTD(TDSplayNode* root, int value) {
+    return insertTD(value, root);
+}
+
+TDSplayNode* delete_SplayTD(TDSplayNode* root, int value) {
+    return deleteTD(value, root);
+}
+
+void free_SplayTD(TDSplayNode* node) {
+    if (node == NULL) return;
+    free_SplayTD(node->left);
+    free_SplayTD(node->right);
+    free(node);
+}
+
+void release_SplayTD(TDSplayNode* node) {
+    if (useArena) poolReset(&SplayTDpool);
+    else free_SplayTD(node);
+}
+
+
+// B+-tree: the nodes are always malloc'ed, --arena does not apply to it
+void release_BPT(BPTNode* node) {
+    freeBPT(node);
+}
+
+
+// Searches with the (root, value) -> root signature the workload macro expects
+// The splay trees bring a key they find to the root, which is what makes them fast on skewed reads
+BSTNode* search_BST(BSTNode* root, int value) {
+    workloadHits += searchBST(root, value) != NULL;
+    return root;
+}
+
+AVLNode* search_AVL(AVLNode* root, int value) {
+    workloadHits += searchAVL(root, value) != NULL;
+    return root;
+}
+
+SplayNode* search_Splay(SplayNode* root, int value) {
+    SplayNode* target = search(value, root);
+    if (target) {
+        workloadHits++;
+        root = splay(target, root);
+    }
+    return root;
+}
+
+TDSplayNode* search_SplayTD(TDSplayNode* root, int value) {
+    root = searchTD(value, root);
+    workloadHits += root != NULL && root->val == value;
+    return root;
+}
+
+BPTNode* search_BPT(BPTNode* root, int value) {
+    workloadHits += searchBPT(root, value);
+    return root;
+}
+
+// One phase of --latency goes to the console and to both result files
+static void write_latency(const char* name, int n, const char* order_type, const char* phase, const LatencyHistogram* hist, const PerfCounters* perf) {
+    report_latency(name, n, order_type, phase, hist);
+    writeLatencyCSV(latencyCSV, name, n, order_type, phase, hist, perf);
+    writeLatencyJSON(latencyJSON, name, n, order_type, phase, hist, perf);
+}
+
+// One tree of --sweep: the statistics of its rounds go to the console and to the sweep results file
+static void report_sweep(FILE* file, const char* name, int n, const char* order_type, const double* samples, int count) {
+    SampleStats stats;
+    sampleStats(samples, count, &stats);
+    if (ftell(file) == 0) {
+        fprintf(file, "tree,n,order,reps,mean_s,stddev_s,ci95_low_s,ci95_high_s,min_s\n");
+    }
+    fprintf(file, "%s,%d,%s,%d,%f,%f,%f,%f,%f\n", name, n, order_type, count,
+            stats.mean, stats.stddev, stats.ciLow, stats.ciHigh, stats.min);
+    printf("Sweep of %s with N=%d (%s): mean %f s, stddev %f s, 95%% CI [%f, %f] over %d rounds\n",
+           name, n, order_type, stats.mean, stats.stddev, stats.ciLow, stats.ciHigh, count);
+}
+
+// Name of a tree in a workload run, e.g. "AVL-iter-95/5/0-zipf:0.99"
+static const char* workload_label(char* buf, size_t size, const char* tree, const WorkloadMix* mix, const KeyDistribution* dist) {
+    snprintf(buf, size, "%s-%s-%s", tree, mix->name, dist->name);
+    return buf;
+}
+
+// Runs every tree on every mix and key distribution picked for --workload
+static void run_workloads(const int* values, int n, const char* order_type, FILE* file) {
+    static const char* defaultMixes[] = { "95/5/0", "50/25/25" };
+    static const char* defaultDists[] = { "uniform", "zipf", "hot", "sliding" };
+    int mixCount = mixArg ? 1 : 2;
+    int distCount = distArg ? 1 : 4;
+    char label[64], name[160];
+    BSTNode* (*BSTinsert)(BSTNode*, int) = useIter ? insertBSTIter : insertBST;
+    BSTNode* (*BSTdelete)(BSTNode*, int) = useIter ? deleteBSTIter : deleteBST;
+    AVLNode* (*AVLinsert)(AVLNode*, int) = useIter ? insertAVLIter : insertAVL;
+    AVLNode* (*AVLdelete)(AVLNode*, int) = useIter ? deleteAVLIter : deleteAVL;
+    BSTNode* BSTroot;
+    AVLNode* AVLroot;
+    SplayNode* Splayroot;
+    TDSplayNode* SplayTDroot;
+    BPTNode* BPTroot;
+
+    for (int m = 0; m < mixCount; m++) {
+        for (int d = 0; d < distCount; d++) {
+            WorkloadMix mix;
+            KeyDistribution dist;
+            Workload work;
+            parseMix(mixArg ? mixArg : defaultMixes[m], &mix);
+            parseDistribution(distArg ? distArg : defaultDists[d], &dist);
+            if (!makeWorkload(&work, values, n, &mix, &dist, workloadOps)) {
+                perror("Memory allocation failed");
+                return;
+            }
+            TEST_WORKLOAD(workload_label(name, sizeof(name), tree_label(label, sizeof(label), "BST", 1), &mix, &dist), BST, BSTroot, BSTinsert, BSTdelete, search_BST, &work, file);
+            TEST_WORKLOAD(workload_label(name, sizeof(name), tree_label(label, sizeof(label), "AVL", 1), &mix, &dist), AVL, AVLroot, AVLinsert, AVLdelete, search_AVL, &work, file);
+            TEST_WORKLOAD(workload_label(name, sizeof(name), tree_label(label, sizeof(label), "Splay", 0), &mix, &dist), Splay, Splayroot, insert_Splay, delete_Splay, search_Splay, &work, file);
+            TEST_WORKLOAD(workload_label(name, sizeof(name), tree_label(label, sizeof(label), "SplayTD", 0), &mix, &dist), SplayTD, SplayTDroot, insert_SplayTD, delete_SplayTD, search_SplayTD, &work, file);
+            TEST_WORKLOAD(workload_label(name, sizeof(name), "BPT", &mix, &dist), BPT, BPTroot, insertBPT, deleteBPT, search_BPT, &work, file);
+            freeWorkload(&work);
+        }
+    }
+}
+
+// --lookups: every tree holds the whole data set and searches for the keys of the lookup stream
+static void run_lookups(const int* values, int n, const int* lookups, int lookupCount, const char* order_type, FILE* file) {
+    Workload work;
+    work.ops = (WorkloadOp*)malloc(sizeof(WorkloadOp) * (size_t)lookupCount);
+    if (work.ops == NULL) {
+        perror("Memory allocation failed");
+        return;
+    }
+    for (int i = 0; i < lookupCount; i++) {
+        work.ops[i].type = OP_READ;
+        work.ops[i].key = lookups[i];
+    }
+    work.count = lookupCount;
+    work.preload = (int*)values;
+    work.preloadCount = n;
+    char label[64], name[80];
+    BSTNode* (*BSTinsert)(BSTNode*, int) = useIter ? insertBSTIter : insertBST;
+    BSTNode* (*BSTdelete)(BSTNode*, int) = useIter ? deleteBSTIter : deleteBST;
+    AVLNode* (*AVLinsert)(AVLNode*, int) = useIter ? insertAVLIter : insertAVL;
+    AVLNode* (*AVLdelete)(AVLNode*, int) = useIter ? deleteAVLIter : deleteAVL;
+    BSTNode* BSTroot;
+    AVLNode* AVLroot;
+    SplayNode* Splayroot;
+    TDSplayNode* SplayTDroot;
+    BPTNode* BPTroot;
+
+    snprintf(name, sizeof(name), "%s-lookup", tree_label(label, sizeof(label), "BST", 1));
+    TEST_WORKLOAD(name, BST, BSTroot, BSTinsert, BSTdelete, search_BST, &work, file);
+    snprintf(name, sizeof(name), "%s-lookup", tree_label(label, sizeof(label), "AVL", 1));
+    TEST_WORKLOAD(name, AVL, AVLroot, AVLinsert, AVLdelete, search_AVL, &work, file);
+    snprintf(name, sizeof(name), "%s-lookup", tree_label(label, sizeof(label), "Splay", 0));
+    TEST_WORKLOAD(name, Splay, Splayroot, insert_Splay, delete_Splay, search_Splay, &work, file);
+    snprintf(name, sizeof(name), "%s-lookup", tree_label(label, sizeof(label), "SplayTD", 0));
+    TEST_WORKLOAD(name, SplayTD, SplayTDroot, insert_SplayTD, delete_SplayTD, search_SplayTD, &work, file);
+    TEST_WORKLOAD("BPT-lookup", BPT, BPTroot, insertBPT, deleteBPT, search_BPT, &work, file);
+    free(work.ops);
+}
+
+// The baseline for --bulk: build the same tree with n single inserts
+BSTNode* insertAll_BST(const int* values, int n) {
+    BSTNode* root = NULL;
+    for (int i = 0; i < n; i++) {
+        root = useIter ? insertBSTIter(root, values[i]) : insertBST(root, values[i]);
+    }
+    return root;
+}
+
+AVLNode* insertAll_AVL(const int* values, int n) {
+    AVLNode* root = NULL;
+    for (int i = 0; i < n; i++) {
+        root = useIter ? insertAVLIter(root, values[i]) : insertAVL(root, values[i]);
+    }
+    return root;
+}
+
+// The compact trees keep their state in compactTree, the macro's root is just a handle to it (NULL before the first insert)
+CompactTree* insert_BSTC(CompactTree* tree, int value) { (void)tree; compactInsertBST(&compactTree, value); return &compactTree; }
+CompactTree* delete_BSTC(CompactTree* tree, int value) { (void)tree; compactDeleteBST(&compactTree, value); return &compactTree; }
+CompactTree* insert_AVLC(CompactTree* tree, int value) { (void)tree; compactInsertAVL(&compactTree, value); return &compactTree; }
+CompactTree* delete_AVLC(CompactTree* tree, int value) { (void)tree; compactDeleteAVL(&compactTree, value); return &compactTree; }
+CompactTree* insert_SplayC(CompactTree* tree, int value) { (void)tree; compactInsertSplay(&compactTree, value); return &compactTree; }
+CompactTree* delete_SplayC(CompactTree* tree, int value) { (void)tree; compactDeleteSplay(&compactTree, value); return &compactTree; }
+
+// Clearing the compact layout is always O(1), the node array is kept for the next repetition
+void release_BSTC(CompactTree* tree) { (void)tree; compactClear(&compactTree); }
+void release_AVLC(CompactTree* tree) { (void)tree; compactClear(&compactTree); }
+void release_SplayC(CompactTree* tree) { (void)tree; compactClear(&compactTree); }
+
+
+static void init_pools(void) {
+    poolInit(&BSTpool, sizeof(BSTNode), 0);
+    poolInit(&AVLpool, sizeof(AVLNode), 0);
+    poolInit(&Splaypool, sizeof(SplayNode), 0);
+    poolInit(&SplayTDpool, sizeof(TDSplayNode), 0);
+    setBSTPool(&BSTpool);
+    setAVLPool(&AVLpool);
+    setSplayPool(&Splaypool);
+    setTDSplayPool(&SplayTDpool);
+}
+
+static void destroy_pools(void) {
+    setBSTPool(NULL);
+    setAVLPool(NULL);
+    setSplayPool(NULL);
+    setTDSplayPool(NULL);
+    poolDestroy(&BSTpool);
+    poolDestroy(&AVLpool);
+    poolDestroy(&Splaypool);
+    poolDestroy(&SplayTDpool);
+}
+
+// The path of a stream random_generator wrote for this data set: test_data/<stream>_<n>_<order>.bin,
+// or the .txt fallback; returns 0 (with the .txt path) if neither exists
+static int stream_path(char* path, size_t size, const char* stream, int n, const char* order_type) {
+    snprintf(path, size, "test_data/%s_%d_%s.bin", stream, n, order_type);
+    if (access(path, R_OK) == 0) return 1;
+    snprintf(path, size, "test_data/%s_%d_%s.txt", stream, n, order_type);
+    return access(path, R_OK) == 0;
+}
+
+// Is name one of the comma separated entries of list
+static int in_list(const char* list, const char* name) {
+    size_t len = strlen(name);
+    while (*list) {
+        const char* end = strchr(list, ',');
+        size_t itemLen = end ? (size_t)(end - list) : strlen(list);
+        if (itemLen == len && strncmp(list, name, len) == 0) return 1;
+        if (end == NULL) break;
+        list = end + 1;
+    }
+    return 0;
+}
+
+// Every entry of the order list of --sweep has to be an order random_generator knows
+static int valid_orders(const char* list) {
+    char order_type[32];
+    while (1) {
+        const char* end = strchr(list, ',');
+        size_t len = end ? (size_t)(end - list) : strlen(list);
+        KeyOrder order;
+        if (len >= sizeof(order_type)) return 0;
+        memcpy(order_type, list, len);
+        order_type[len] = '\0';
+        if (!parseKeyOrder(order_type, &order)) return 0;
+        if (end == NULL) return 1;
+        list = end + 1;
+    }
+}
+
+// Checks the list of --splay-policy the same way
+static int valid_splay_policies(const char* list) {
+    char policy_text[32];
+    if (strlen(list) >= 256) return 0;   // bench_splay_policies() takes the list apart in a buffer of this size
+    while (1) {
+        const char* end = strchr(list, ',');
+        size_t len = end ? (size_t)(end - list) : strlen(list);
+        SplayPolicy policy;
+        if (len >= sizeof(policy_text)) return 0;
+        memcpy(policy_text, list, len);
+        policy_text[len] = '\0';
+        if (!parseSplayPolicy(policy_text, &policy)) return 0;
+        if (end == NULL) return 1;
+        list = end + 1;
+    }
+}
+
+// Parses the sizes of --sweep: a comma separated list of numbers (1e8 is fine) and ranges first:last:step
+static int parse_sizes(const char* text, int* sizes, int maxSizes) {
+    int count = 0;
+    while (*text) {
+        char* end;
+        double first = strtod(text, &end);
+        double last = first, step = 1;
+        if (*end == ':') {
+            last = strtod(end + 1, &end);
+            if (*end != ':') return 0;
+            step = strtod(end + 1, &end);
+        }
+        if ((*end != ',' && *end != '\0') || first < 1 || last < first || step < 1 || last > 2147483647.0) return 0;
+        for (double size = first; size <= last; size += step) {
+            if (count == maxSizes) return 0;
+            sizes[count++] = (int)size;
+        }
+        text = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+// --sweep: every size and order in one process, each data set is generated once and shared by all the trees
+#define SWEEP_MAX_SIZES 256
+static int run_sweep(const char* sizeList, const char* orderList) {
+    int sizes[SWEEP_MAX_SIZES];
+    int sizeCount = parse_sizes(sizeList, sizes, SWEEP_MAX_SIZES);
+    if (sizeCount == 0) {
+        fprintf(stderr, "Error: --sweep needs sizes like 1000,5000 or 1000:10000:1000.\n");
+        return 1;
+    }
+    if (!valid_orders(orderList)) {
+        fprintf(stderr, "Error: --sweep needs orders like inc,rand,zipf:0.99 (see random_generator).\n");
+        return 1;
+    }
+    int maxN = 0;
+    for (int s = 0; s < sizeCount; s++) {
+        if (sizes[s] > maxN) maxN = sizes[s];
+    }
+
+    int* values = (int*)malloc(sizeof(int) * (size_t)maxN);
+    int* deletes = (int*)malloc(sizeof(int) * (size_t)maxN);
+    sweepSamples = (double*)malloc(sizeof(double) * sweepReps);
+    FILE* file = fopen("test_data/sweep_results.csv", "a");
+    if (values == NULL || deletes == NULL || sweepSamples == NULL || file == NULL) {
+        perror(file == NULL ? "Failed to open test_data/sweep_results.csv" : "Memory allocation failed");
+        free(values);
+        free(deletes);
+        free(sweepSamples);
+        if (file) fclose(file);
+        return 1;
+    }
+    if (useArena) init_pools();
+
+    BSTNode* (*BSTinsert)(BSTNode*, int) = useIter ? insertBSTIter : insertBST;
+    BSTNode* (*BSTdelete)(BSTNode*, int) = useIter ? deleteBSTIter : deleteBST;
+    AVLNode* (*AVLinsert)(AVLNode*, int) = useIter ? insertAVLIter : insertAVL;
+    AVLNode* (*AVLdelete)(AVLNode*, int) = useIter ? deleteAVLIter : deleteAVL;
+    BSTNode* BSTroot;
+    AVLNode* AVLroot;
+    SplayNode* Splayroot;
+    TDSplayNode* SplayTDroot;
+    BPTNode* BPTroot;
+    char label[64];
+
+    const char* list = orderList;
+    while (*list) {
+        const char* end = strchr(list, ',');
+        size_t len = end ? (size_t)(end - list) : strlen(list);
+        char order_type[32];
+        KeyOrder order;
+        memcpy(order_type, list, len);
+        order_type[len] = '\0';
+        parseKeyOrder(order_type, &order);
+        list = end ? end + 1 : list + len;
+        for (int s = 0; s < sizeCount; s++) {
+            int n = sizes[s];
+            if (!generateKeyStreams(&order, n, 0, values, deletes, NULL, 0)) {
+                perror("Memory allocation failed");
+                break;
+            }
+            if (in_list(sweepTrees, "BST")) TEST_SWEEP(tree_label(label, sizeof(label), "BST", 1), BST, BSTroot, BSTinsert, BSTdelete, values, deletes, n, file);
+            if (in_list(sweepTrees, "AVL")) TEST_SWEEP(tree_label(label, sizeof(label), "AVL", 1), AVL, AVLroot, AVLinsert, AVLdelete, values, deletes, n, file);
+            if (in_list(sweepTrees, "Splay")) TEST_SWEEP(tree_label(label, sizeof(label), "Splay", 0), Splay, Splayroot, insert_Splay, delete_Splay, values, deletes, n, file);
+            if (in_list(sweepTrees, "SplayTD")) TEST_SWEEP(tree_label(label, sizeof(label), "SplayTD", 0), SplayTD, SplayTDroot, insert_SplayTD, delete_SplayTD, values, deletes, n, file);
+            if (in_list(sweepTrees, "BPT")) TEST_SWEEP("BPT", BPT, BPTroot, insertBPT, deleteBPT, values, deletes, n, file);
+            fflush(file);
+        }
+    }
+
+    if (useArena) destroy_pools();
+    free(values);
+    free(deletes);
+    free(sweepSamples);
+    fclose(file);
+    return 0;
+}
+
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <N> <order_type>\n", argv[0]);
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <N> <order_type> [options]\n", argv[0]);
         fprintf(stderr, "  <N>: Number of integers\n");
-        fprintf(stderr, "  <order_type>: 'inc', 'dec', or 'rand'\n");
+        fprintf(stderr, "  <order_type>: 'inc', 'dec', 'rand', or one of the orders of random_generator, e.g. 'zipf:0.99'\n");
+        fprintf(stderr, "  --arena: allocate nodes from a slab pool instead of malloc/free\n");
+        fprintf(stderr, "  --iter: use the iterative insert/delete engines for BST and AVL\n");
+        fprintf(stderr, "  --bulk: also time bulk loading BST and AVL against n single inserts\n");
+        fprintf(stderr, "  --setops: also time AVL union/intersection/difference built on join and split\n");
+        fprintf(stderr, "  --compact: also run BST, AVL and Splay on the index-based node layout\n");
+        fprintf(stderr, "  --rank: also time range counts with the AVL and Splay subtree sizes\n");
+        fprintf(stderr, "  --snapshot: also time lookups on Eytzinger/vEB snapshots against the live AVL tree\n");
+        fprintf(stderr, "  --workload: also run read/insert/delete mixes with skewed keys and report ops/sec\n");
+        fprintf(stderr, "  --mix <r/i/d>: the operation mix for --workload (default: 95/5/0 and 50/25/25)\n");
+        fprintf(stderr, "  --dist <d>: uniform, zipf[:s], hot[:keys:ops] or sliding[:window] (default: all four)\n");
+        fprintf(stderr, "  --ops <k>: number of operations per workload run (default: 1000000)\n");
+        fprintf(stderr, "  --concurrent: also time lock-free AVL lookups on 1 to 64 threads while a writer updates the tree\n");
+        fprintf(stderr, "  --lookups: also time searches for the keys of test_data/lookup_<N>_<order_type>.bin/.txt\n");
+        fprintf(stderr, "  --persistent: also time AVL snapshots by path copying against full copies, with their memory\n");
+        fprintf(stderr, "  --image: also time restarting AVL and BST from a saved tree image, mapped or rebuilt in O(N)\n");
+        fprintf(stderr, "  --splay-policy <list>: also time reads on Splay with full, semi, every[:k], depth[:d] and random[:p]\n");
+        fprintf(stderr, "                         splaying and count the nodes they write (keys from --dist, default zipf)\n");
+        fprintf(stderr, "  --keytypes: also time BST, AVL and Splay on int32, int64 and string keys\n");
+        fprintf(stderr, "  --latency: also write per-operation latency percentiles and hardware counters\n");
+        fprintf(stderr, "             to test_data/latency_results.csv and test_data/latency_results.json\n");
+        fprintf(stderr, "  --sweep: <N> and <order_type> are lists instead (e.g. 1000:10000:1000 inc,dec,rand),\n");
+        fprintf(stderr, "           the data sets are generated in memory and the statistics go to test_data/sweep_results.csv\n");
+        fprintf(stderr, "  --warmup <k>, --reps <k>: untimed and timed rounds per tree for --sweep (default: 1 and 10)\n");
+        fprintf(stderr, "  --trees <list>: the trees --sweep runs (default: BST,AVL,Splay,SplayTD,BPT)\n");
+        fprintf(stderr, "  --threads <k>: number of threads for the parallel modes (default: all cores)\n");
         return 1;
     }
 
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--arena") == 0) {
+            useArena = 1;
+        } else if (strcmp(argv[i], "--iter") == 0) {
+            useIter = 1;
+        } else if (strcmp(argv[i], "--bulk") == 0) {
+            useBulk = 1;
+        } else if (strcmp(argv[i], "--setops") == 0) {
+            useSetOps = 1;
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            useCompact = 1;
+        } else if (strcmp(argv[i], "--rank") == 0) {
+            useRank = 1;
+        } else if (strcmp(argv[i], "--snapshot") == 0) {
+            useSnapshot = 1;
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            useSweep = 1;
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            sweepWarmup = atoi(argv[++i]);
+            if (sweepWarmup < 0) {
+                fprintf(stderr, "Error: --warmup needs a number >= 0.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            sweepReps = atoi(argv[++i]);
+            if (sweepReps <= 0) {
+                fprintf(stderr, "Error: --reps needs a positive number.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--trees") == 0 && i + 1 < argc) {
+            sweepTrees = argv[++i];
+        } else if (strcmp(argv[i], "--concurrent") == 0) {
+            useConcurrent = 1;
+        } else if (strcmp(argv[i], "--lookups") == 0) {
+            useLookups = 1;
+        } else if (strcmp(argv[i], "--persistent") == 0) {
+            usePersistent = 1;
+        } else if (strcmp(argv[i], "--image") == 0) {
+            useImage = 1;
+        } else if (strcmp(argv[i], "--splay-policy") == 0 && i + 1 < argc) {
+            splayPolicies = argv[++i];
+            if (!valid_splay_policies(splayPolicies)) {
+                fprintf(stderr, "Error: --splay-policy needs a list of full, semi, every[:k], depth[:d] or random[:p].\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--keytypes") == 0) {
+            useKeyTypes = 1;
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            useLatency = 1;
+        } else if (strcmp(argv[i], "--workload") == 0) {
+            useWorkload = 1;
+        } else if (strcmp(argv[i], "--mix") == 0 && i + 1 < argc) {
+            WorkloadMix mix;
+            mixArg = argv[++i];
+            if (!parseMix(mixArg, &mix)) {
+                fprintf(stderr, "Error: --mix needs read/insert/delete weights, e.g. 95/5/0.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--dist") == 0 && i + 1 < argc) {
+            KeyDistribution dist;
+            distArg = argv[++i];
+            if (!parseDistribution(distArg, &dist)) {
+                fprintf(stderr, "Error: unknown key distribution '%s'.\n", distArg);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            workloadOps = atoi(argv[++i]);
+            if (workloadOps <= 0) {
+                fprintf(stderr, "Error: --ops needs a positive number.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            if (threads <= 0) {
+                fprintf(stderr, "Error: --threads needs a positive number.\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Error: unknown option '%s'.\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (useSweep) {
+        return run_sweep(argv[1], argv[2]);
+    }
+
     int n = atoi(argv[1]);
+    if (threads == 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (threads <= 0) threads = 1;
+    }
     const char *order_type = argv[2];
 
     if (n <= 0) {
@@ -85,46 +751,54 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // The binary data set of random_generator --binary is mapped straight into memory, the text one is the fallback
     char input_path[100];
-    sprintf(input_path, "test_data/input_%d_%s.txt", n, order_type);
-
-    FILE *input_file = fopen(input_path, "r");
-    if (input_file == NULL) {
-        perror("Failed to open input file");
+    stream_path(input_path, sizeof(input_path), "input", n, order_type);
+    Dataset dataset;
+    if (!openDataset(&dataset, input_path, n)) {
         return 1;
     }
+    if (dataset.binary && strcmp(dataset.info.order, order_type) != 0) {
+        fprintf(stderr, "Warning: %s was generated as '%s'.\n", input_path, dataset.info.order);
+    }
 
-    int *tempArray = (int*)calloc(n, sizeof(int));
-    int *deleteArray = (int*)calloc(n, sizeof(int)); // 新增
-    if (tempArray == NULL || deleteArray == NULL) {
+    const int *tempArray = dataset.values;
+    int *deleteArray = (int*)malloc(sizeof(int) * n); // 新增
+    if (deleteArray == NULL) {
         perror("Memory allocation failed");
-        fclose(input_file);
-        free(tempArray);
-        free(deleteArray);
+        closeDataset(&dataset);
         return 1;
     }
-    
-    // Read data
-    for (int i = 0; i < n; i++) {
-        fscanf(input_file, "%d", tempArray + i);
-        deleteArray[i] = tempArray[i]; // 复制
-    }
-    fclose(input_file);
 
-    // 按 order_type 洗牌 deleteArray
-    if(strcmp(order_type, "dec") == 0) {
-        for(int i = 0; i < n / 2; i++) {
-            int temp = deleteArray[i];
-            deleteArray[i] = deleteArray[n - i - 1];
-            deleteArray[n - i - 1] = temp;
+    // random_generator --deletes writes the delete order next to the data set, otherwise it follows order_type
+    char delete_path[100];
+    if (stream_path(delete_path, sizeof(delete_path), "delete", n, order_type)) {
+        Dataset deletes;
+        if (!openDataset(&deletes, delete_path, n)) {
+            closeDataset(&dataset);
+            free(deleteArray);
+            return 1;
         }
-    } else if(strcmp(order_type, "rand") == 0) {
-        srand(time(NULL));
-        for(int i = n - 1; i > 0; i--) {
-            int j = rand() % (i + 1);
-            int temp = deleteArray[i];
-            deleteArray[i] = deleteArray[j];
-            deleteArray[j] = temp;
+        memcpy(deleteArray, deletes.values, sizeof(int) * n);
+        closeDataset(&deletes);
+    } else {
+        memcpy(deleteArray, tempArray, sizeof(int) * n); // 复制
+        // 按 order_type 洗牌 deleteArray
+        if(strcmp(order_type, "dec") == 0) {
+            for(int i = 0; i < n / 2; i++) {
+                int temp = deleteArray[i];
+                deleteArray[i] = deleteArray[n - i - 1];
+                deleteArray[n - i - 1] = temp;
+            }
+        } else if(strcmp(order_type, "rand") == 0) {
+            KeyRng rng;
+            seedKeyRng(&rng, (uint64_t)time(NULL));
+            for(int i = n - 1; i > 0; i--) {
+                int j = (int)keyRngBelow(&rng, (uint32_t)i + 1);
+                int temp = deleteArray[i];
+                deleteArray[i] = deleteArray[j];
+                deleteArray[j] = temp;
+            }
         }
     }
 
@@ -132,26 +806,147 @@ int main(int argc, char *argv[]) {
     FILE *output_file = fopen("test_data/performance_results.txt", "a");
     if (output_file == NULL) {
         perror("Failed to open output file");
-        free(tempArray);
+        closeDataset(&dataset);
         free(deleteArray);
         return 1;
     }
 
     double total_time;
+    char label[32];
+
+    // The same macro drives both engines, only the function pointers differ
+    BSTNode* (*BSTinsert)(BSTNode*, int) = useIter ? insertBSTIter : insertBST;
+    BSTNode* (*BSTdelete)(BSTNode*, int) = useIter ? deleteBSTIter : deleteBST;
+    AVLNode* (*AVLinsert)(AVLNode*, int) = useIter ? insertAVLIter : insertAVL;
+    AVLNode* (*AVLdelete)(AVLNode*, int) = useIter ? deleteAVLIter : deleteAVL;
+
+    if (useArena) {
+        init_pools();
+    }
 
     // 1. Test BST
     BSTNode *BSTroot = NULL;
-    TEST_INSERT_DELETE("BST", BST, BSTroot, insertBST, deleteBST, tempArray, deleteArray, n, output_file, total_time);
+    TEST_INSERT_DELETE(tree_label(label, sizeof(label), "BST", 1), BST, BSTroot, BSTinsert, BSTdelete, tempArray, deleteArray, n, output_file, total_time);
 
     // 2. Test AVL Tree
+    // With -DTREE_STATS the AVL and Splay runs also count rotations, comparisons and depths
     AVLNode *AVLroot = NULL;
-    TEST_INSERT_DELETE("AVL", AVL, AVLroot, insertAVL, deleteAVL, tempArray, deleteArray, n, output_file, total_time);
+    STATS_RESET();
+    TEST_INSERT_DELETE(tree_label(label, sizeof(label), "AVL", 1), AVL, AVLroot, AVLinsert, AVLdelete, tempArray, deleteArray, n, output_file, total_time);
+    STATS_REPORT(label, n, order_type);
     
     // 3. Test Splay Tree
     SplayNode *Splayroot = NULL;
-    TEST_INSERT_DELETE("Splay", Splay, Splayroot, insert_Splay, delete_Splay, tempArray, deleteArray, n, output_file, total_time);
+    STATS_RESET();
+    TEST_INSERT_DELETE(tree_label(label, sizeof(label), "Splay", 0), Splay, Splayroot, insert_Splay, delete_Splay, tempArray, deleteArray, n, output_file, total_time);
+    STATS_REPORT(label, n, order_type);
+
+    // 4. Test top-down Splay Tree
+    TDSplayNode *SplayTDroot = NULL;
+    TEST_INSERT_DELETE(tree_label(label, sizeof(label), "SplayTD", 0), SplayTD, SplayTDroot, insert_SplayTD, delete_SplayTD, tempArray, deleteArray, n, output_file, total_time);
+
+    // 5. Test B+-tree with wide nodes
+    BPTNode *BPTroot = NULL;
+    TEST_INSERT_DELETE("BPT", BPT, BPTroot, insertBPT, deleteBPT, tempArray, deleteArray, n, output_file, total_time);
+
+    // 6. Bulk loading against single inserts
+    if (useBulk) {
+        { TEST_BUILD(tree_label(label, sizeof(label), "BST-inserts", 1), BST, BSTroot, insertAll_BST, tempArray, n, output_file, total_time); }
+        { TEST_BUILD(tree_label(label, sizeof(label), "BST-bulk", 0), BST, BSTroot, buildBST, tempArray, n, output_file, total_time); }
+        { TEST_BUILD(tree_label(label, sizeof(label), "AVL-inserts", 1), AVL, AVLroot, insertAll_AVL, tempArray, n, output_file, total_time); }
+        { TEST_BUILD(tree_label(label, sizeof(label), "AVL-bulk", 0), AVL, AVLroot, buildAVL, tempArray, n, output_file, total_time); }
+    }
+
+    // 7. Set algebra on AVL trees
+    if (useSetOps) {
+        bench_set_ops(tempArray, n, order_type, output_file, threads);
+    }
+
+    // 8. The shared index-based layout
+    if (useCompact) {
+        CompactTree *Croot = NULL;
+        compactInit(&compactTree, n);
+        TEST_INSERT_DELETE("BST-compact", BSTC, Croot, insert_BSTC, delete_BSTC, tempArray, deleteArray, n, output_file, total_time);
+        TEST_INSERT_DELETE("AVL-compact", AVLC, Croot, insert_AVLC, delete_AVLC, tempArray, deleteArray, n, output_file, total_time);
+        TEST_INSERT_DELETE("Splay-compact", SplayC, Croot, insert_SplayC, delete_SplayC, tempArray, deleteArray, n, output_file, total_time);
+        compactDestroy(&compactTree);
+        bench_layout_bytes(tempArray, n, order_type, output_file);
+    }
+
+    // 9. Order statistics
+    if (useRank) {
+        bench_range_count(tempArray, n, order_type, output_file);
+    }
+
+    // 10. Read-only snapshots
+    if (useSnapshot) {
+        bench_snapshot(tempArray, n, order_type, output_file);
+    }
+
+    // 11. Mixed and skewed workloads
+    if (useWorkload) {
+        run_workloads(tempArray, n, order_type, output_file);
+    }
+
+    // 12. Per-operation latency and hardware counters
+    if (useLatency) {
+        latencyCSV = fopen("test_data/latency_results.csv", "a");
+        latencyJSON = fopen("test_data/latency_results.json", "a");
+        if (latencyCSV == NULL || latencyJSON == NULL) {
+            perror("Failed to open latency output file");
+        } else {
+            TEST_LATENCY(tree_label(label, sizeof(label), "BST", 1), BST, BSTroot, BSTinsert, BSTdelete, tempArray, deleteArray, n);
+            TEST_LATENCY(tree_label(label, sizeof(label), "AVL", 1), AVL, AVLroot, AVLinsert, AVLdelete, tempArray, deleteArray, n);
+            TEST_LATENCY(tree_label(label, sizeof(label), "Splay", 0), Splay, Splayroot, insert_Splay, delete_Splay, tempArray, deleteArray, n);
+            TEST_LATENCY(tree_label(label, sizeof(label), "SplayTD", 0), SplayTD, SplayTDroot, insert_SplayTD, delete_SplayTD, tempArray, deleteArray, n);
+            TEST_LATENCY("BPT", BPT, BPTroot, insertBPT, deleteBPT, tempArray, deleteArray, n);
+        }
+        if (latencyCSV) fclose(latencyCSV);
+        if (latencyJSON) fclose(latencyJSON);
+    }
+
+    // 13. Concurrent readers
+    if (useConcurrent) {
+        bench_concurrent(tempArray, n, order_type, output_file);
+    }
+
+    // 14. Key types
+    if (useKeyTypes) {
+        bench_key_types(tempArray, deleteArray, n, order_type, output_file);
+    }
+
+    // 15. Lookup stream
+    if (useLookups) {
+        char lookup_path[100];
+        Dataset lookups;
+        if (!stream_path(lookup_path, sizeof(lookup_path), "lookup", n, order_type)) {
+            fprintf(stderr, "Error: --lookups needs %s, written by random_generator --lookups.\n", lookup_path);
+        } else if (openDataset(&lookups, lookup_path, 0)) {
+            run_lookups(tempArray, n, lookups.values, lookups.count, order_type, output_file);
+            closeDataset(&lookups);
+        }
+    }
+
+    // 16. Persistent snapshots
+    if (usePersistent) {
+        bench_persistent(tempArray, n, order_type, output_file);
+    }
+
+    // 17. Tree images
+    if (useImage) {
+        bench_image(tempArray, n, order_type, output_file);
+    }
+
+    // 18. Splay policies
+    if (splayPolicies) {
+        bench_splay_policies(tempArray, n, order_type, output_file, splayPolicies, distArg);
+    }
+
+    if (useArena) {
+        destroy_pools();
+    }
 
-    free(tempArray);
+    closeDataset(&dataset);
     free(deleteArray);
     fclose(output_file);
 
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "measure.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static const char* perfNames[PERF_EVENTS] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+
+uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void latencyInit(LatencyHistogram* hist) {
+    memset(hist, 0, sizeof(LatencyHistogram));
+}
+
+static int bucketOf(uint64_t ns) {
+    if (ns >= (1ULL << LAT_MAX_BITS)) {
+        ns = (1ULL << LAT_MAX_BITS) - 1;
+    }
+    if (ns < (1ULL << LAT_SUB_BITS)) {
+        return (int)ns;
+    }
+    int shift = 63 - __builtin_clzll(ns) - LAT_SUB_BITS;
+    // the top LAT_SUB_BITS + 1 bits of ns pick the bucket, the bits below are dropped
+    return ((shift + 1) << LAT_SUB_BITS) + (int)((ns >> shift) - (1ULL << LAT_SUB_BITS));
+}
+
+static uint64_t highestInBucket(int bucket) {
+    if (bucket < (1 << LAT_SUB_BITS)) {
+        return (uint64_t)bucket;
+    }
+    int shift = (bucket >> LAT_SUB_BITS) - 1;
+    uint64_t low = ((1ULL << LAT_SUB_BITS) + (uint64_t)(bucket & ((1 << LAT_SUB_BITS) - 1))) << shift;
+    return low + (1ULL << shift) - 1;
+}
+
+void latencyRecord(LatencyHistogram* hist, uint64_t ns) {
+    hist->counts[bucketOf(ns)]++;
+    hist->total++;
+    hist->sum += ns;
+    if (ns > hist->max) hist->max = ns;
+}
+
+uint64_t latencyPercentile(const LatencyHistogram* hist, double p) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p * (double)hist->total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > hist->total) rank = hist->total;
+    uint64_t seen = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+        seen += hist->counts[b];
+        if (seen >= rank) {
+            uint64_t value = highestInBucket(b);
+            return value < hist->max ? value : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+#ifdef __linux__
+static int openCounter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // every counter is opened on its own: a group would fail as a whole if the CPU lacks one event
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+void perfOpen(PerfCounters* perf) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        perf->fds[e] = -1;
+        perf->values[e] = 0;
+    }
+#ifdef __linux__
+    perf->fds[PERF_CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    perf->fds[PERF_INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    perf->fds[PERF_L1D_MISSES] = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    perf->fds[PERF_LLC_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    perf->fds[PERF_BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+}
+
+void perfStart(PerfCounters* perf) {
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (perf->fds[e] >= 0) {
+            ioctl(perf->fds[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf->fds[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+void perfStop(PerfCounters* perf) {
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (perf->fds[e] >= 0) {
+            uint64_t value = 0;
+            ioctl(perf->fds[e], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(perf->fds[e], &value, sizeof(value)) == sizeof(value)) {
+                perf->values[e] += value;
+            }
+        }
+    }
+#endif
+}
+
+void perfClose(PerfCounters* perf) {
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (perf->fds[e] >= 0) close(perf->fds[e]);
+        perf->fds[e] = -1;
+    }
+#endif
+}
+
+void writeLatencyCSV(FILE* file, const char* name, int n, const char* order_type, const char* phase,
+                     const LatencyHistogram* hist, const PerfCounters* perf) {
+    if (ftell(file) == 0) {
+        fprintf(file, "tree,n,order,phase,ops,mean_ns,p50_ns,p99_ns,p999_ns,max_ns");
+        for (int e = 0; e < PERF_EVENTS; e++) fprintf(file, ",%s", perfNames[e]);
+        fprintf(file, "\n");
+    }
+    fprintf(file, "%s,%d,%s,%s,%llu,%.1f,%llu,%llu,%llu,%llu", name, n, order_type, phase,
+            (unsigned long long)hist->total, hist->total ? (double)hist->sum / hist->total : 0.0,
+            (unsigned long long)latencyPercentile(hist, 0.5), (unsigned long long)latencyPercentile(hist, 0.99),
+            (unsigned long long)latencyPercentile(hist, 0.999), (unsigned long long)hist->max);
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        // an unavailable counter is left empty
+        if (perf->fds[e] >= 0) fprintf(file, ",%llu", (unsigned long long)perf->values[e]);
+        else fprintf(file, ",");
+    }
+    fprintf(file, "\n");
+}
+
+void writeLatencyJSON(FILE* file, const char* name, int n, const char* order_type, const char* phase,
+                      const LatencyHistogram* hist, const PerfCounters* perf) {
+    // JSON lines: one object per line, so that runs can keep appending to the same file
+    fprintf(file, "{\"tree\":\"%s\",\"n\":%d,\"order\":\"%s\",\"phase\":\"%s\",\"ops\":%llu,\"mean_ns\":%.1f,"
+            "\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu", name, n, order_type, phase,
+            (unsigned long long)hist->total, hist->total ? (double)hist->sum / hist->total : 0.0,
+            (unsigned long long)latencyPercentile(hist, 0.5), (unsigned long long)latencyPercentile(hist, 0.99),
+            (unsigned long long)latencyPercentile(hist, 0.999), (unsigned long long)hist->max);
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (perf->fds[e] >= 0) fprintf(file, ",\"%s\":%llu", perfNames[e], (unsigned long long)perf->values[e]);
+        else fprintf(file, ",\"%s\":null", perfNames[e]);
+    }
+    fprintf(file, "}\n");
+}
+
+void report_latency(const char* name, int n, const char* order_type, const char* phase, const LatencyHistogram* hist) {
+    printf("Latency of %s %s with N=%d (%s): p50 %llu ns, p99 %llu ns, p999 %llu ns, max %llu ns\n",
+           name, phase, n, order_type,
+           (unsigned long long)latencyPercentile(hist, 0.5), (unsigned long long)latencyPercentile(hist, 0.99),
+           (unsigned long long)latencyPercentile(hist, 0.999), (unsigned long long)hist->max);
+}
+
+// Two-sided 95% quantiles of Student's t distribution for 1 to 30 degrees of freedom
+static const double tTable[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+void sampleStats(const double* samples, int count, SampleStats* stats) {
+    double sum = 0, squares = 0;
+    stats->count = count;
+    stats->min = count > 0 ? samples[0] : 0;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+        if (samples[i] < stats->min) stats->min = samples[i];
+    }
+    stats->mean = count > 0 ? sum / count : 0;
+    for (int i = 0; i < count; i++) {
+        squares += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+    }
+    stats->stddev = count > 1 ? sqrt(squares / (count - 1)) : 0;
+    double t = count <= 1 ? 0 : (count - 1 <= 30 ? tTable[count - 2] : 1.960);
+    // beyond 30 degrees of freedom the normal quantile is close enough
+    double half = count > 0 ? t * stats->stddev / sqrt((double)count) : 0;
+    stats->ciLow = stats->mean - half;
+    stats->ciHigh = stats->mean + half;
+}
@@ -0,0 +1,64 @@
+#ifndef MEASURE_HEADER
+#define MEASURE_HEADER
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Per-operation measurements for --latency
+// A latency histogram in the style of HdrHistogram: exact below 2^LAT_SUB_BITS ns, and above that
+// every power of two is split into 2^LAT_SUB_BITS buckets, so a percentile is off by less than 1%
+// Hardware counters come from perf_event_open() on Linux; a counter the kernel refuses stays unavailable
+
+#define LAT_SUB_BITS 7
+#define LAT_MAX_BITS 40    // about 18 minutes, anything slower lands in the last bucket
+#define LAT_BUCKETS ((LAT_MAX_BITS - LAT_SUB_BITS + 1) << LAT_SUB_BITS)
+
+typedef struct LatencyHistogram {
+    uint64_t counts[LAT_BUCKETS];
+    uint64_t total;
+    uint64_t sum;    // for the mean
+    uint64_t max;
+} LatencyHistogram;
+
+uint64_t now_ns(void);   // CLOCK_MONOTONIC in nanoseconds
+void latencyInit(LatencyHistogram* hist);
+void latencyRecord(LatencyHistogram* hist, uint64_t ns);
+uint64_t latencyPercentile(const LatencyHistogram* hist, double p);   // p in [0, 1], the bucket's highest value
+
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_L1D_MISSES 2
+#define PERF_LLC_MISSES 3
+#define PERF_BRANCH_MISSES 4
+#define PERF_EVENTS 5
+
+typedef struct PerfCounters {
+    int fds[PERF_EVENTS];          // -1 if the counter could not be opened
+    uint64_t values[PERF_EVENTS];  // summed over every perfStart()/perfStop() pair
+} PerfCounters;
+
+void perfOpen(PerfCounters* perf);   // counts this thread in user space only
+void perfStart(PerfCounters* perf);
+void perfStop(PerfCounters* perf);
+void perfClose(PerfCounters* perf);
+
+// One line per tree, N, order and phase; the CSV file gets its header when it is still empty
+void writeLatencyCSV(FILE* file, const char* name, int n, const char* order_type, const char* phase,
+                     const LatencyHistogram* hist, const PerfCounters* perf);
+void writeLatencyJSON(FILE* file, const char* name, int n, const char* order_type, const char* phase,
+                      const LatencyHistogram* hist, const PerfCounters* perf);
+// Summary of repeated timings, for --sweep
+typedef struct SampleStats {
+    int count;
+    double mean;
+    double stddev;   // sample standard deviation, 0 for a single sample
+    double ciLow;    // 95% confidence interval of the mean, from Student's t distribution
+    double ciHigh;
+    double min;
+} SampleStats;
+
+void sampleStats(const double* samples, int count, SampleStats* stats);
+
+void report_latency(const char* name, int n, const char* order_type, const char* phase, const LatencyHistogram* hist);
+
+#endif
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+#define POOL_ALIGN 16
+//the slab header is padded so that the first node of a slab is aligned as well
+#define SLAB_HEADER ((sizeof(PoolSlab) + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN)
+
+void poolInit(NodePool* pool, size_t nodeSize, size_t slabNodes)
+{
+    if (nodeSize < sizeof(void*)) {
+        nodeSize = sizeof(void*);
+        //a released node must be able to hold the free list link
+    }
+    pool->nodeSize = (nodeSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+    pool->slabNodes = slabNodes > 0 ? slabNodes : 4096;
+    pool->firstSlab = NULL;
+    pool->currSlab = NULL;
+    pool->cursor = NULL;
+    pool->end = NULL;
+    pool->freeList = NULL;
+    pool->liveNodes = 0;
+}
+
+static int nextSlab(NodePool* pool)
+{
+    //move on to the slab after the current one, and only ask the system for memory
+    //when there is no slab left over from an earlier round
+    PoolSlab* slab = pool->currSlab ? pool->currSlab->next : pool->firstSlab;
+    if (slab == NULL) {
+        slab = (PoolSlab*)malloc(SLAB_HEADER + pool->nodeSize * pool->slabNodes);
+        if (slab == NULL) {
+            return 0;
+        }
+        slab->next = NULL;
+        if (pool->currSlab == NULL) {
+            pool->firstSlab = slab;
+        } else {
+            pool->currSlab->next = slab;
+        }
+    }
+    pool->currSlab = slab;
+    pool->cursor = (char*)slab + SLAB_HEADER;
+    pool->end = pool->cursor + pool->nodeSize * pool->slabNodes;
+    return 1;
+}
+
+void* poolAlloc(NodePool* pool)
+{
+    void* node;
+    if (pool->freeList != NULL) {
+        //reuse the most recently released node first, it is likely to be still in cache
+        node = pool->freeList;
+        pool->freeList = *(void**)node;
+    } else {
+        if (pool->cursor == pool->end && !nextSlab(pool)) {
+            return NULL;
+        }
+        node = pool->cursor;
+        pool->cursor += pool->nodeSize;
+    }
+    memset(node, 0, pool->nodeSize);
+    pool->liveNodes++;
+    return node;
+}
+
+void poolFree(NodePool* pool, void* node)
+{
+    if (node == NULL) {
+        return;
+    }
+    *(void**)node = pool->freeList;
+    pool->freeList = node;
+    pool->liveNodes--;
+}
+
+void poolReset(NodePool* pool)
+{
+    //all the nodes die together, so we only rewind to the first slab
+    //the slabs themselves stay allocated and are handed out again by nextSlab()
+    pool->currSlab = NULL;
+    pool->cursor = NULL;
+    pool->end = NULL;
+    pool->freeList = NULL;
+    pool->liveNodes = 0;
+}
+
+void poolDestroy(NodePool* pool)
+{
+    PoolSlab* slab = pool->firstSlab;
+    while (slab != NULL) {
+        PoolSlab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    pool->firstSlab = NULL;
+    poolReset(pool);
+}
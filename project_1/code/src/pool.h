@@ -0,0 +1,32 @@
+#ifndef POOL_HEADER
+#define POOL_HEADER
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//a slab arena for fixed-size tree nodes
+//nodes are carved out of large slabs, deleted nodes go to a free list and are reused first,
+//and the whole pool can be emptied in O(1) with poolReset() instead of walking the tree
+typedef struct PoolSlab {
+    struct PoolSlab* next;
+    //the slabs are chained so that poolReset() can keep them for the next round
+} PoolSlab;
+
+typedef struct NodePool {
+    size_t nodeSize;      //size of one node, rounded up so that every node stays aligned
+    size_t slabNodes;     //number of nodes carved out of every slab
+    PoolSlab* firstSlab;
+    PoolSlab* currSlab;   //the slab we are currently carving nodes from
+    char* cursor;         //next unused node in the current slab
+    char* end;            //end of the current slab
+    void* freeList;       //nodes released by poolFree(), linked through their first bytes
+    size_t liveNodes;     //number of nodes handed out and not released yet
+} NodePool;
+
+void poolInit(NodePool* pool, size_t nodeSize, size_t slabNodes);
+void* poolAlloc(NodePool* pool);              //returns a zeroed node
+void poolFree(NodePool* pool, void* node);    //gives a single node back for reuse
+void poolReset(NodePool* pool);               //releases every node at once, the slabs are kept
+void poolDestroy(NodePool* pool);             //gives all the slabs back to the system
+
+#endif
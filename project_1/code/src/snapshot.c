@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "snapshot.h"
+
+#define CACHE_LINE 64
+
+static void* allocAligned(size_t bytes)
+{
+    //the arrays start on a cache line, so that the 16 keys a prefetch pulls in share one line
+    bytes = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+#ifdef _WIN32
+    return _aligned_malloc(bytes, CACHE_LINE);
+#else
+    void* p = NULL;
+    return posix_memalign(&p, CACHE_LINE, bytes) == 0 ? p : NULL;
+#endif
+}
+
+static void freeAligned(void* p)
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+static int fillEytzinger(const int* sorted, int* keys, int i, long long k, int n)
+{
+    //an in-order walk over the implicit tree hands out the sorted keys one by one
+    if (k <= n) {
+        i = fillEytzinger(sorted, keys, i, 2 * k, n);
+        keys[k] = sorted[i++];
+        i = fillEytzinger(sorted, keys, i, 2 * k + 1, n);
+    }
+    return i;
+}
+
+static void splitVEB(Snapshot* s, int depth, int height)
+{
+    //a tree of the given height hanging at depth is cut into a top tree of height / 2 levels
+    //and the bottom trees below it; the first depth of the bottom trees remembers where it was cut
+    if (height <= 1) {
+        return;
+    }
+    int topHeight = height / 2;
+    int bottomHeight = height - topHeight;
+    s->vebTopDepth[depth + topHeight] = depth;
+    s->vebTop[depth + topHeight] = (1LL << topHeight) - 1;
+    s->vebBottom[depth + topHeight] = (1LL << bottomHeight) - 1;
+    splitVEB(s, depth, topHeight);
+    splitVEB(s, depth + topHeight, bottomHeight);
+}
+
+static int fillVEB(Snapshot* s, const int* sorted)
+{
+    //every BFS index i at depth d finds its vEB slot from the slot of its ancestor at vebTopDepth[d]:
+    //skip that top tree, then skip the bottom trees to the left of ours, which the low bits of i count
+    long long* slotOf = (long long*)malloc(sizeof(long long) * (size_t)(s->slots + 1));
+    if (slotOf == NULL) {
+        return 0;
+    }
+    int height = s->height;
+    slotOf[1] = 0;
+    for (int d = 0; d < height; d ++) {
+        for (long long i = 1LL << d; i < (1LL << (d + 1)); i ++) {
+            if (d > 0) {
+                long long ancestor = i >> (d - s->vebTopDepth[d]);
+                slotOf[i] = slotOf[ancestor] + s->vebTop[d] + (i & s->vebTop[d]) * s->vebBottom[d];
+            }
+            long long inorder = ((i - (1LL << d)) * 2 + 1) * (1LL << (height - 1 - d)) - 1;
+            //the position of i in an in-order walk of the complete tree
+            s->keys[slotOf[i]] = inorder < s->n ? sorted[inorder] : INT_MAX;
+        }
+    }
+    free(slotOf);
+    return 1;
+}
+
+Snapshot* freezeSorted(const int* sorted, int n, int layout)
+{
+    Snapshot* s = (Snapshot*)calloc(1, sizeof(Snapshot));
+    if (s == NULL) {
+        return NULL;
+    }
+    s->layout = layout;
+    s->n = n;
+    s->maxKey = n > 0 ? sorted[n - 1] : INT_MIN;
+    while (s->height < SNAPSHOT_MAX_HEIGHT - 1 && (1LL << s->height) - 1 < n) {
+        s->height ++;
+    }
+    if (layout == SNAPSHOT_VEB) {
+        s->slots = (1LL << s->height) - 1;
+        //the vEB layout needs a complete tree, the missing keys are padded with INT_MAX
+        splitVEB(s, 0, s->height);
+    } else {
+        s->slots = (long long)n + 1;
+    }
+    s->keys = (int*)allocAligned(sizeof(int) * (size_t)(s->slots > 0 ? s->slots : 1));
+    if (s->keys == NULL) {
+        free(s);
+        return NULL;
+    }
+    if (layout == SNAPSHOT_VEB) {
+        if (n > 0 && !fillVEB(s, sorted)) {
+            freeSnapshot(s);
+            return NULL;
+        }
+    } else {
+        fillEytzinger(sorted, s->keys, 0, 1, n);
+    }
+    return s;
+}
+
+void freeSnapshot(Snapshot* snapshot)
+{
+    if (snapshot == NULL) {
+        return;
+    }
+    freeAligned(snapshot->keys);
+    free(snapshot);
+}
+
+//an in-order walk with an explicit stack, the BST can be far too deep for recursion
+#define COLLECT_INORDER(NodeType, name) \
+static int* name(NodeType* root, int* count) \
+{ \
+    int capacity = 1024, n = 0, depth = 0, stackSize = 64; \
+    int* out = (int*)malloc(sizeof(int) * capacity); \
+    NodeType** stack = (NodeType**)malloc(sizeof(NodeType*) * stackSize); \
+    if (out == NULL || stack == NULL) { \
+        free(out); \
+        free(stack); \
+        return NULL; \
+    } \
+    NodeType* node = root; \
+    while (node != NULL || depth > 0) { \
+        while (node != NULL) { \
+            if (depth == stackSize) { \
+                stackSize *= 2; \
+                stack = (NodeType**)realloc(stack, sizeof(NodeType*) * stackSize); \
+                if (stack == NULL) { \
+                    free(out); \
+                    return NULL; \
+                } \
+            } \
+            stack[depth++] = node; \
+            node = node->left; \
+        } \
+        node = stack[--depth]; \
+        if (n == capacity) { \
+            capacity *= 2; \
+            out = (int*)realloc(out, sizeof(int) * capacity); \
+            if (out == NULL) { \
+                free(stack); \
+                return NULL; \
+            } \
+        } \
+        out[n++] = node->val; \
+        node = node->right; \
+    } \
+    free(stack); \
+    *count = n; \
+    return out; \
+}
+
+COLLECT_INORDER(AVLNode, collectAVL)
+COLLECT_INORDER(BSTNode, collectBST)
+COLLECT_INORDER(SplayNode, collectSplay)
+
+#define FREEZE_WITH(collect) \
+    int n; \
+    int* sorted = collect(root, &n); \
+    if (sorted == NULL) { \
+        return NULL; \
+    } \
+    Snapshot* s = freezeSorted(sorted, n, layout); \
+    free(sorted); \
+    return s;
+
+Snapshot* freezeAVL(AVLNode* root, int layout)
+{
+    FREEZE_WITH(collectAVL)
+}
+
+Snapshot* freezeBST(BSTNode* root, int layout)
+{
+    FREEZE_WITH(collectBST)
+}
+
+Snapshot* freezeSplay(SplayNode* root, int layout)
+{
+    FREEZE_WITH(collectSplay)
+}
+
+static long long lowerBoundEytzinger(const Snapshot* s, int key)
+{
+    const int* keys = s->keys;
+    long long n = s->n;
+    long long k = 1;
+    while (k <= n) {
+        __builtin_prefetch(keys + k * 16);
+        //the 16 descendants four levels down share one cache line, fetch it while we compare
+        k = 2 * k + (keys[k] < key);
+    }
+    k >>= __builtin_ffsll(~k);
+    //undo the right turns after the last left turn, which was at the answer
+    return k;
+}
+
+static long long lowerBoundVEB(const Snapshot* s, int key)
+{
+    long long slot[SNAPSHOT_MAX_HEIGHT];
+    long long i = 1;
+    long long answer = -1;
+    for (int d = 0; d < s->height; d ++) {
+        slot[d] = d == 0 ? 0 : slot[s->vebTopDepth[d]] + s->vebTop[d] + (i & s->vebTop[d]) * s->vebBottom[d];
+        int value = s->keys[slot[d]];
+        answer = value >= key ? slot[d] : answer;
+        i = 2 * i + (value < key);
+    }
+    return answer;
+}
+
+int snapshotLowerBound(const Snapshot* snapshot, int key, int* result)
+{
+    if (snapshot->n == 0) {
+        return 0;
+    }
+    if (snapshot->layout == SNAPSHOT_VEB) {
+        long long slot = lowerBoundVEB(snapshot, key);
+        if (slot < 0 || (snapshot->keys[slot] == INT_MAX && snapshot->maxKey != INT_MAX)) {
+            return 0;
+            //only the padding is >= key
+        }
+        *result = snapshot->keys[slot];
+        return 1;
+    }
+    long long k = lowerBoundEytzinger(snapshot, key);
+    if (k == 0) {
+        return 0;
+    }
+    *result = snapshot->keys[k];
+    return 1;
+}
+
+int snapshotContains(const Snapshot* snapshot, int key)
+{
+    int found;
+    return snapshotLowerBound(snapshot, key, &found) && found == key;
+}
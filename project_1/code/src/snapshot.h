@@ -0,0 +1,43 @@
+#ifndef SNAPSHOT_HEADER
+#define SNAPSHOT_HEADER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "AVLTree.h"
+#include "BST.h"
+#include "splay.h"
+
+//an immutable, read-optimized copy of a tree for the long read-only phases
+//the keys are stored in one array in an implicit layout, so a search follows no pointers at all:
+//  SNAPSHOT_EYTZINGER: BFS order (the children of slot k are 2k and 2k+1), searched with prefetching
+//  SNAPSHOT_VEB: van Emde Boas order, which is cache-oblivious: every subtree of height h
+//                sits in 2^h - 1 consecutive slots
+//both searches are branchless, the loop runs the same number of rounds for every key
+
+#define SNAPSHOT_EYTZINGER 0
+#define SNAPSHOT_VEB 1
+#define SNAPSHOT_MAX_HEIGHT 32
+
+typedef struct Snapshot {
+    int layout;
+    int n;            //number of keys
+    int height;       //height of the implicit tree (levels)
+    long long slots;  //slots in keys
+    int* keys;        //Eytzinger: keys[1..n], keys[0] unused; vEB: a complete tree padded with INT_MAX
+    int maxKey;       //the biggest real key, tells the vEB padding apart from a real INT_MAX
+    long long vebTop[SNAPSHOT_MAX_HEIGHT];      //for every depth: size of the top tree it hangs from,
+    long long vebBottom[SNAPSHOT_MAX_HEIGHT];   //size of the bottom trees,
+    int vebTopDepth[SNAPSHOT_MAX_HEIGHT];       //and depth of the root of that top tree
+} Snapshot;
+
+Snapshot* freezeSorted(const int* keys, int n, int layout);  //keys must be sorted in increasing order
+Snapshot* freezeAVL(AVLNode* root, int layout);
+Snapshot* freezeBST(BSTNode* root, int layout);
+Snapshot* freezeSplay(SplayNode* root, int layout);
+void freeSnapshot(Snapshot* snapshot);
+
+int snapshotLowerBound(const Snapshot* snapshot, int key, int* result);
+//finds the smallest key >= key, returns 0 if there is none
+int snapshotContains(const Snapshot* snapshot, int key);
+
+#endif
@@ -1,41 +1,70 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "splay.h"
+#include "treestats.h"
+#include "keyorder.h"
+
+static NodePool *splayPool=NULL;//when a pool is set, all the nodes come from it instead of malloc()
+
+void setSplayPool(NodePool *pool)
+{
+    splayPool=pool;
+}
 
 SplayNode *createnode(int k) //initialize a tree whose val is k
 {
-    SplayNode *new=(SplayNode *)malloc(sizeof(SplayNode));
+    SplayNode *new;
+    if(splayPool)
+        new=(SplayNode *)poolAlloc(splayPool);
+    else
+        new=(SplayNode *)malloc(sizeof(SplayNode));
     new->left=NULL;
     new->right=NULL;
     new->parent=NULL;
     new->val=k;
+    new->size=1;
     return new;
 }
+static int sizeof_tree(SplayNode *root)//the size of a subtree, 0 if it is empty
+{
+    return root?root->size:0;
+}
+
+static void update_size(SplayNode *root)
+{
+    root->size=sizeof_tree(root->left)+sizeof_tree(root->right)+1;
+}
+
 SplayNode *insert(SplayNode *newnode,SplayNode *root) //insert a new node following the rule of BST
 {
     if(root==NULL)
       return newnode;
-    if(newnode->val>root->val) 
+    STATS_VISIT();
+    if(STATS_GT(newnode->val,root->val)) 
     {
       root->right=insert(newnode,root->right);//insert to the right subtree,using recursion
       if(root->right) //avoid that root->right==NULL;
         root->right->parent=root;//establish the parent-child relationship
     } 
-    else if(newnode->val<root->val) 
+    else if(STATS_LT(newnode->val,root->val)) 
     {
       root->left=insert(newnode,root->left);//insert to the left subtree,using recursion
       if(root->left)//root->right==NULL;
         root->left->parent=root;//establish the parent-child relationship
     }
+    update_size(root);//every node on the insertion path gets one more node below it
     return root;
 }
 SplayNode *search(int k, SplayNode *root) {
     SplayNode *cur=root;
     while(cur) 
     {
-        if (cur->val==k)//find the target
+        STATS_VISIT();
+        if (STATS_EQ(cur->val,k))//find the target
             return cur;
-        if (cur->val>k)
+        if (STATS_GT(cur->val,k))
             cur=cur->left;//target in the left subtree
         else
             cur=cur->right;//target in the right subtree
@@ -67,6 +96,8 @@ void rightrotate(SplayNode *root, SplayNode *newnode) //right rotate the child n
     root->left=nr;//establish the parent-child relationship between root and previous newnode's right son
     if(nr)
         nr->parent=root;
+    update_size(root);//root is now below newnode, so it has to be updated first
+    update_size(newnode);
 }
 
 void leftrotate(SplayNode *root, SplayNode *newnode)//left rotate the child node 
@@ -93,6 +124,8 @@ void leftrotate(SplayNode *root, SplayNode *newnode)//left rotate the child node
     root->right=nl;//establish the parent-child relationship between root and previous newnode's left son
     if(nl)
         nl->parent=root;
+    update_size(root);
+    update_size(newnode);
 }
 SplayNode* splay(SplayNode *newnode, SplayNode *root) 
 {
@@ -102,6 +135,7 @@ SplayNode* splay(SplayNode *newnode, SplayNode *root)
         SplayNode *grandparent=parent->parent;
         if (grandparent==NULL) //newnode is the son of root;
         {
+            STATS_SPLAY_STEP(zig,1);
             if (parent->left==newnode)
                 rightrotate(parent,newnode);
             else
@@ -109,25 +143,30 @@ SplayNode* splay(SplayNode *newnode, SplayNode *root)
         } 
         else if(grandparent->left==parent&&parent->left==newnode) //case "zig-zig"
         {
+            STATS_SPLAY_STEP(zigZig,2);
             rightrotate(grandparent,parent);//first rotate the parent node
             rightrotate(parent,newnode);//then rotate newnode 
         } 
         else if(grandparent->right==parent&&parent->right==newnode) //case "zig-zig"
         {
+            STATS_SPLAY_STEP(zigZig,2);
             leftrotate(grandparent,parent);//first rotate the parent node
             leftrotate(parent,newnode);//then rotate newnode 
         } 
         else if(grandparent->left==parent&&parent->right==newnode) //case "zig-zag"
         {
+            STATS_SPLAY_STEP(zigZag,2);
             leftrotate(parent,newnode);//rotate the newnode node
             rightrotate(grandparent,newnode);//rotate newnode again
         } 
         else if(grandparent->right==parent&&parent->left==newnode) //case "zig-zag"
         {
+            STATS_SPLAY_STEP(zigZag,2);
             rightrotate(parent,newnode);//rotate the newnode
             leftrotate(grandparent,newnode);//rotate newnode again
         }
     }
+    STATS_SPLAY_END();
     return newnode;
 }
 
@@ -136,7 +175,10 @@ SplayNode *findmax(SplayNode *root) //according to the rule of BST,the maximum v
     if (!root) 
         return NULL;
     while(root->right)
+    {
+        STATS_VISIT();
         root=root->right;
+    }
     return root;
 }
 
@@ -161,6 +203,7 @@ SplayNode *delete(SplayNode *root) //delete the node whose value is k
         if(root->right)
             root->right->parent=new_root;
         new_root->parent=NULL;
+        update_size(new_root);
     } 
     else if(root->left) //if the root has only left subtree
     {
@@ -173,10 +216,18 @@ SplayNode *delete(SplayNode *root) //delete the node whose value is k
         new_root->parent=NULL;
     }
     
-    free(root);
+    freenode(root);
     return new_root;
 }
 
+void freenode(SplayNode *node)//give a single node back to the pool or the system
+{
+    if(splayPool)
+        poolFree(splayPool,node);
+    else
+        free(node);
+}
+
 void Traverse(SplayNode *root)//When programminng splay.c,we use this function to examine the splay tree.
 {
     if (!root) return;
@@ -185,3 +236,201 @@ void Traverse(SplayNode *root)//When programminng splay.c,we use this function t
     Traverse(root->right);
     return ;
 }
+
+int rankSplay(int k, SplayNode *root)//like search(), the order statistics do not splay
+{
+    int rank=0;
+    while(root)
+    {
+        if(k<=root->val)
+            root=root->left;
+        else
+        {
+            rank+=sizeof_tree(root->left)+1;//root and its left subtree are smaller than k
+            root=root->right;
+        }
+    }
+    return rank;
+}
+
+SplayNode *selectSplay(int k, SplayNode *root)
+{
+    while(root)
+    {
+        int leftsize=sizeof_tree(root->left);
+        if(k<=leftsize)
+            root=root->left;
+        else if(k==leftsize+1)
+            return root;
+        else
+        {
+            k-=leftsize+1;
+            root=root->right;
+        }
+    }
+    return NULL;
+}
+
+int countRangeSplay(int lo, int hi, SplayNode *root)
+{
+    if(lo>hi)
+        return 0;
+    int atmost=0;//the number of keys <= hi
+    SplayNode *cur=root;
+    while(cur)
+    {
+        if(hi<cur->val)
+            cur=cur->left;
+        else
+        {
+            atmost+=sizeof_tree(cur->left)+1;
+            cur=cur->right;
+        }
+    }
+    return atmost-rankSplay(lo,root);
+}
+
+//the policy searches count the nodes their rotations write here, so the rotations that insert, delete and every other
+//benchmark use stay as they are
+static void rotate_up(SplayNode *newnode, SplayPolicy *policy)//rotates newnode above its parent
+{
+    SplayNode *parent=newnode->parent;
+    SplayNode *moved=parent->left==newnode?newnode->right:newnode->left;
+    if(parent->left==newnode)
+        rightrotate(parent,newnode);
+    else
+        leftrotate(parent,newnode);
+    policy->written+=2+(newnode->parent!=NULL)+(moved!=NULL);//parent, newnode, the grandparent and the moved subtree
+}
+
+static SplayNode *policy_splay(SplayNode *newnode, SplayPolicy *policy)//splay(), with the rotations counted
+{
+    while(newnode->parent!=NULL)
+    {
+        SplayNode *parent=newnode->parent;
+        SplayNode *grandparent=parent->parent;
+        if(grandparent==NULL) //newnode is the son of root
+        {
+            STATS_SPLAY_STEP(zig,1);
+            rotate_up(newnode,policy);
+        }
+        else if((grandparent->left==parent)==(parent->left==newnode)) //case "zig-zig"
+        {
+            STATS_SPLAY_STEP(zigZig,2);
+            rotate_up(parent,policy);//first rotate the parent node
+            rotate_up(newnode,policy);//then rotate newnode
+        }
+        else //case "zig-zag"
+        {
+            STATS_SPLAY_STEP(zigZag,2);
+            rotate_up(newnode,policy);
+            rotate_up(newnode,policy);
+        }
+    }
+    STATS_SPLAY_END();
+    return newnode;
+}
+
+static SplayNode *semisplay(SplayNode *newnode, SplayNode *root, SplayPolicy *policy)//the root after semi-splaying newnode
+{
+    while(newnode->parent!=NULL&&newnode->parent->parent!=NULL)//a child of the root is left where it is
+    {
+        SplayNode *parent=newnode->parent;
+        SplayNode *grandparent=parent->parent;
+        if((grandparent->left==parent)==(parent->left==newnode)) //case "zig-zig"
+        {
+            STATS_SPLAY_STEP(zigZig,1);
+            rotate_up(parent,policy);//only the parent goes up
+            newnode=parent;//and the climbing goes on from the parent
+        }
+        else //case "zig-zag", the same as in splay()
+        {
+            STATS_SPLAY_STEP(zigZag,2);
+            rotate_up(newnode,policy);
+            rotate_up(newnode,policy);
+        }
+        if(newnode->parent==NULL)//the grandparent was the root
+            root=newnode;
+    }
+    STATS_SPLAY_END();
+    return root;
+}
+
+int parseSplayPolicy(const char *text, SplayPolicy *policy)
+{
+    memset(policy,0,sizeof(*policy));
+    policy->state=0x5DEECE66DULL;
+    if(strcmp(text,"full")==0)
+        policy->kind=SPLAY_FULL;
+    else if(strcmp(text,"semi")==0)
+        policy->kind=SPLAY_SEMI;
+    else if((policy->param=8,parseNamed(text,"every",&policy->param)))
+    {
+        policy->kind=SPLAY_EVERY;
+        if(policy->param<1||policy->param!=floor(policy->param))
+            return 0;
+    }
+    else if((policy->param=0,parseNamed(text,"depth",&policy->param)))
+    {
+        policy->kind=SPLAY_DEPTH;//0 stands for 2 log2 of the tree size
+        if(policy->param<0||policy->param!=floor(policy->param))
+            return 0;
+    }
+    else if((policy->param=0.1,parseNamed(text,"random",&policy->param)))
+    {
+        policy->kind=SPLAY_RANDOM;
+        if(policy->param<0||policy->param>1)
+            return 0;
+    }
+    else
+        return 0;
+    snprintf(policy->name,sizeof(policy->name),"%s",text);
+    return 1;
+}
+
+static double next_uniform(unsigned long long *state)//splitmix64, scaled to [0, 1)
+{
+    unsigned long long z=(*state+=0x9E3779B97F4A7C15ULL);
+    z=(z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+    z=(z^(z>>27))*0x94D049BB133111EBULL;
+    return ((z^(z>>31))>>11)*(1.0/9007199254740992.0);
+}
+
+SplayNode *searchSplayPolicy(int k, SplayNode *root, SplayPolicy *policy, int *found)
+{
+    SplayNode *cur=root;
+    int depth=0;
+    while(cur)
+    {
+        STATS_VISIT();
+        if(STATS_EQ(cur->val,k))
+            break;
+        cur=STATS_GT(cur->val,k)?cur->left:cur->right;
+        depth++;
+    }
+    *found=cur!=NULL;
+    if(cur==NULL)//like search_Splay(), a miss leaves the tree alone
+        return root;
+    policy->searches++;
+    switch(policy->kind)
+    {
+        case SPLAY_SEMI:
+            return semisplay(cur,root,policy);
+        case SPLAY_EVERY:
+            if(policy->searches%(unsigned long long)policy->param!=0)
+                return root;
+            break;
+        case SPLAY_DEPTH:
+        {
+            double threshold=policy->param>0?policy->param:2*log2((double)root->size);
+            if(depth<=threshold)
+                return root;
+            break;
+        }
+        case SPLAY_RANDOM:
+            if(next_uniform(&policy->state)>=policy->param)
+                return root;
+            break;
+    }
+    return policy_splay(cur,policy);
+}
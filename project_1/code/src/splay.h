@@ -3,12 +3,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include "pool.h"
 
 typedef struct node {
     struct node *left;
     struct node *right;
     struct node *parent;
     int val;
+    int size;//the number of nodes in the subtree rooted here, used for the order statistics
 } SplayNode;
 
 SplayNode* createnode(int k);
@@ -17,5 +19,35 @@ SplayNode* search(int k, SplayNode *root);
 SplayNode* delete(SplayNode *root);
 SplayNode* splay(SplayNode *newnode, SplayNode *root);
 void Traverse(SplayNode *root);
+int rankSplay(int k, SplayNode *root);//the number of keys smaller than k
+SplayNode* selectSplay(int k, SplayNode *root);//the node holding the k-th smallest key (k starts at 1)
+int countRangeSplay(int lo, int hi, SplayNode *root);//the number of keys in [lo, hi]
+void setSplayPool(NodePool *pool);//allocate nodes from the pool, NULL goes back to malloc/free
+void freenode(SplayNode *node);
+
+//how far a search moves the node it found; every tree can have its own policy, insert and delete always splay fully
+//  full: splay to the root
+//  semi: semi-splay, a zig-zig only rotates the parent up and climbing goes on from there, so the path is halved
+//        and the node found ends up near the root instead of at it
+//  every:k: splay on every k-th search of the tree only
+//  depth:d: splay only if the node found is more than d edges below the root
+//  random:p: splay with probability p
+#define SPLAY_FULL 0
+#define SPLAY_SEMI 1
+#define SPLAY_EVERY 2
+#define SPLAY_DEPTH 3
+#define SPLAY_RANDOM 4
+
+typedef struct SplayPolicy {
+    int kind;
+    double param;//k, d or p
+    unsigned long long searches;//searches done with the policy so far
+    unsigned long long state;//random:p draws from its own generator, so runs are repeatable
+    unsigned long long written;//nodes whose links or sizes the rotations of its searches have changed so far
+    char name[32];
+} SplayPolicy;
+
+int parseSplayPolicy(const char *text, SplayPolicy *policy);//returns 0 if text is malformed
+SplayNode* searchSplayPolicy(int k, SplayNode *root, SplayPolicy *policy, int *found);//returns the new root
 
 #endif
\ No newline at end of file
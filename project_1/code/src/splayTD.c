@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "splayTD.h"
+
+static NodePool *tdPool=NULL;//when a pool is set, all the nodes come from it instead of malloc()
+
+void setTDSplayPool(NodePool *pool)
+{
+    tdPool=pool;
+}
+
+static TDSplayNode *createTDnode(int k)
+{
+    TDSplayNode *new;
+    if(tdPool)
+        new=(TDSplayNode *)poolAlloc(tdPool);
+    else
+        new=(TDSplayNode *)malloc(sizeof(TDSplayNode));
+    new->left=NULL;
+    new->right=NULL;
+    new->val=k;
+    return new;
+}
+
+static void freeTDnode(TDSplayNode *node)
+{
+    if(tdPool)
+        poolFree(tdPool,node);
+    else
+        free(node);
+}
+
+TDSplayNode *splayTD(int k, TDSplayNode *root)
+{
+    if(root==NULL)
+        return NULL;
+    TDSplayNode header;//header.right collects the left tree, header.left collects the right tree
+    TDSplayNode *l=&header,*r=&header,*y;
+    header.left=header.right=NULL;
+    while(1)
+    {
+        if(k<root->val)
+        {
+            if(root->left==NULL)
+                break;
+            if(k<root->left->val)//case "zig-zig": rotate right first
+            {
+                y=root->left;
+                root->left=y->right;
+                y->right=root;
+                root=y;
+                if(root->left==NULL)
+                    break;
+            }
+            r->left=root;//link right: root and its right subtree are bigger than k
+            r=root;
+            root=root->left;
+        }
+        else if(k>root->val)
+        {
+            if(root->right==NULL)
+                break;
+            if(k>root->right->val)//case "zig-zig": rotate left first
+            {
+                y=root->right;
+                root->right=y->left;
+                y->left=root;
+                root=y;
+                if(root->right==NULL)
+                    break;
+            }
+            l->right=root;//link left: root and its left subtree are smaller than k
+            l=root;
+            root=root->right;
+        }
+        else
+            break;
+    }
+    l->right=root->left;//assemble the left tree, the middle tree and the right tree
+    r->left=root->right;
+    root->left=header.right;
+    root->right=header.left;
+    return root;
+}
+
+TDSplayNode *insertTD(int k, TDSplayNode *root)//splay once and split the tree around the new node
+{
+    if(root==NULL)
+        return createTDnode(k);
+    root=splayTD(k,root);
+    if(root->val==k)//k is already in the tree
+        return root;
+    TDSplayNode *new=createTDnode(k);
+    if(k<root->val)
+    {
+        new->left=root->left;
+        new->right=root;
+        root->left=NULL;
+    }
+    else
+    {
+        new->right=root->right;
+        new->left=root;
+        root->right=NULL;
+    }
+    return new;
+}
+
+TDSplayNode *searchTD(int k, TDSplayNode *root)
+{
+    return splayTD(k,root);
+}
+
+TDSplayNode *deleteTD(int k, TDSplayNode *root)
+{
+    if(root==NULL)
+        return NULL;
+    root=splayTD(k,root);
+    if(root->val!=k)//k is not in the tree
+        return root;
+    TDSplayNode *new_root;
+    if(root->left==NULL)
+        new_root=root->right;
+    else
+    {
+        new_root=splayTD(k,root->left);//k is bigger than everything on the left, so the maximum comes up with no right child
+        new_root->right=root->right;
+    }
+    freeTDnode(root);
+    return new_root;
+}
@@ -0,0 +1,22 @@
+#ifndef SPLAY_TD_HEADER
+#define SPLAY_TD_HEADER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pool.h"
+
+//top-down splay tree (Sleator and Tarjan)
+//the splay is done on the way down, so a node only needs two links and no parent pointer
+typedef struct tdnode {
+    struct tdnode *left;
+    struct tdnode *right;
+    int val;
+} TDSplayNode;
+
+TDSplayNode* splayTD(int k, TDSplayNode *root);//brings k (or the last node on its search path) to the root
+TDSplayNode* insertTD(int k, TDSplayNode *root);
+TDSplayNode* searchTD(int k, TDSplayNode *root);//returns the new root, k is at the root if it was found
+TDSplayNode* deleteTD(int k, TDSplayNode *root);
+void setTDSplayPool(NodePool *pool);//allocate nodes from the pool, NULL goes back to malloc/free
+
+#endif
@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "treeimage.h"
+
+#define IMAGE_MAGIC "TREEIMG"     //8 bytes with the terminating zero
+#define IMAGE_VERSION 1
+#define IMAGE_BYTE_ORDER 0x01020304u
+#define IMAGE_HEADER_BYTES 32
+
+typedef struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;   //IMAGE_BYTE_ORDER as written by the saving machine
+    uint32_t kind;
+    uint32_t count;       //number of keys, the nodes are [0, count]
+    uint32_t height;      //levels of the tree, 0 if it is empty
+    uint32_t reserved;
+} ImageHeader;
+
+//one node on the stack of the pre-order walk: the tree node and the index of the parent link to patch
+typedef struct ImageStep {
+    const void* node;
+    uint32_t parent;
+    int isRight;
+    uint32_t depth;
+} ImageStep;
+
+//the walk is shared by both node types, they only differ in how to reach the children and the balance
+typedef struct NodeAccess {
+    const void* (*left)(const void* node);
+    const void* (*right)(const void* node);
+    int (*value)(const void* node);
+    int (*balance)(const void* node);   //right height - left height
+} NodeAccess;
+
+static const void* leftAVL(const void* node) { return ((const AVLNode*)node)->left; }
+static const void* rightAVL(const void* node) { return ((const AVLNode*)node)->right; }
+static int valueAVL(const void* node) { return ((const AVLNode*)node)->val; }
+static int balanceAVL(const void* node) { return -getBF((AVLNode*)node); }
+static const void* leftBST(const void* node) { return ((const BSTNode*)node)->left; }
+static const void* rightBST(const void* node) { return ((const BSTNode*)node)->right; }
+static int valueBST(const void* node) { return ((const BSTNode*)node)->val; }
+static int balanceBST(const void* node) { (void)node; return 0; }
+
+//the number of nodes, found with an explicit stack that grows as needed; 0 with an empty tree or no memory
+static uint32_t countNodes(const void* root, const NodeAccess* access)
+{
+    uint32_t count = 0;
+    size_t top = 0, capacity = 64;
+    const void** stack = (const void**)malloc(sizeof(const void*) * capacity);
+    if (stack == NULL) {
+        return 0;
+    }
+    if (root != NULL) {
+        stack[top++] = root;
+    }
+    while (top > 0) {
+        const void* node = stack[--top];
+        count++;
+        if (top + 2 > capacity) {
+            const void** grown = (const void**)realloc(stack, sizeof(const void*) * capacity * 2);
+            if (grown == NULL) {
+                free(stack);
+                return 0;
+            }
+            stack = grown;
+            capacity *= 2;
+        }
+        if (access->right(node)) {
+            stack[top++] = access->right(node);
+        }
+        if (access->left(node)) {
+            stack[top++] = access->left(node);
+        }
+    }
+    free(stack);
+    return count;
+}
+
+//the file is sized first and then filled through a shared mapping, so the image is never held twice in memory
+static int saveImage(const void* root, const NodeAccess* access, int kind, const char* path)
+{
+    uint32_t count = countNodes(root, access);
+    //the walk never holds more pending nodes than the tree has
+    ImageStep* stack = (ImageStep*)malloc(sizeof(ImageStep) * ((size_t)count + 1));
+    if (stack == NULL || (root != NULL && count == 0)) {
+        perror("Memory allocation failed");
+        free(stack);
+        return 0;
+    }
+
+    size_t bytes = IMAGE_HEADER_BYTES + sizeof(CompactNode) * ((size_t)count + 1);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)bytes) != 0) {
+        perror("Failed to create the tree image");
+        if (fd >= 0) {
+            close(fd);
+        }
+        free(stack);
+        return 0;
+    }
+    char* mapping = (char*)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror("Failed to map the tree image");
+        free(stack);
+        return 0;
+    }
+
+    CompactNode* out = (CompactNode*)(mapping + IMAGE_HEADER_BYTES);
+    memset(&out[0], 0, sizeof(CompactNode));
+    uint32_t next = 1, height = 0;
+    int top = 0;
+    if (root != NULL) {
+        stack[top].node = root;
+        stack[top].parent = COMPACT_NIL;
+        stack[top].isRight = 0;
+        stack[top].depth = 1;
+        top++;
+    }
+    while (top > 0) {
+        ImageStep step = stack[--top];
+        uint32_t i = next++;
+        out[i].val = access->value(step.node);
+        out[i].left = (uint32_t)(access->balance(step.node) + 1) << 30;
+        out[i].right = COMPACT_NIL;
+        if (step.parent != COMPACT_NIL) {
+            if (step.isRight) {
+                out[step.parent].right = i;
+            } else {
+                out[step.parent].left |= i;
+            }
+        }
+        if (step.depth > height) {
+            height = step.depth;
+        }
+        //the right child goes on the stack first, so the whole left subtree comes before it
+        const void* children[2] = { access->right(step.node), access->left(step.node) };
+        for (int c = 0; c < 2; c++) {
+            if (children[c] == NULL) {
+                continue;
+            }
+            stack[top].node = children[c];
+            stack[top].parent = i;
+            stack[top].isRight = c == 0;
+            stack[top].depth = step.depth + 1;
+            top++;
+        }
+    }
+    free(stack);
+
+    ImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version = IMAGE_VERSION;
+    header.byteOrder = IMAGE_BYTE_ORDER;
+    header.kind = (uint32_t)kind;
+    header.count = count;
+    header.height = height;
+    memcpy(mapping, &header, sizeof(header));
+    int ok = msync(mapping, bytes, MS_SYNC) == 0;//waits for the write-back, so a failure to write shows up here
+    munmap(mapping, bytes);
+    if (!ok) {
+        perror("Failed to write the tree image");
+    }
+    return ok;
+}
+
+int saveAVLImage(AVLNode* root, const char* path)
+{
+    NodeAccess access = { leftAVL, rightAVL, valueAVL, balanceAVL };
+    return saveImage(root, &access, IMAGE_AVL, path);
+}
+
+int saveBSTImage(BSTNode* root, const char* path)
+{
+    NodeAccess access = { leftBST, rightBST, valueBST, balanceBST };
+    return saveImage(root, &access, IMAGE_BST, path);
+}
+
+int mapTreeImage(TreeImage* image, const char* path)
+{
+    memset(image, 0, sizeof(*image));
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror("Failed to open the tree image");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 0;
+    }
+    ImageHeader header;
+    if (st.st_size < IMAGE_HEADER_BYTES || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+        || memcmp(header.magic, IMAGE_MAGIC, sizeof(header.magic)) != 0 || header.version != IMAGE_VERSION) {
+        fprintf(stderr, "Error: %s is not a version %d tree image.\n", path, IMAGE_VERSION);
+        close(fd);
+        return 0;
+    }
+    if (header.byteOrder != IMAGE_BYTE_ORDER) {
+        fprintf(stderr, "Error: %s was written on a machine with the other byte order.\n", path);
+        close(fd);
+        return 0;
+    }
+    size_t bytes = IMAGE_HEADER_BYTES + sizeof(CompactNode) * ((size_t)header.count + 1);
+    if ((size_t)st.st_size < bytes || header.count > COMPACT_MAX_NODES) {
+        fprintf(stderr, "Error: %s is truncated.\n", path);
+        close(fd);
+        return 0;
+    }
+    void* mapping = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror("Failed to map the tree image");
+        return 0;
+    }
+    image->kind = (int)header.kind;
+    image->mapping = mapping;
+    image->mappingBytes = bytes;
+    image->tree.nodes = (CompactNode*)((char*)mapping + IMAGE_HEADER_BYTES);
+    image->tree.capacity = header.count + 1;
+    image->tree.used = header.count + 1;
+    image->tree.freeList = COMPACT_NIL;
+    image->tree.root = header.count > 0 ? 1 : COMPACT_NIL;
+    image->tree.count = header.count;
+    return 1;
+}
+
+void unmapTreeImage(TreeImage* image)
+{
+    if (image->mapping) {
+        munmap(image->mapping, image->mappingBytes);
+    }
+    memset(image, 0, sizeof(*image));
+}
+
+//every node but the root must be the child of exactly one node that comes before it, otherwise the file is damaged
+//and rebuilding it would share or lose nodes; in pre-order a left child also comes right after its parent
+static int checkImage(const CompactTree* tree)
+{
+    char* hasParent = (char*)calloc((size_t)tree->count + 1, 1);
+    if (hasParent == NULL) {
+        return 0;
+    }
+    int ok = 1;
+    for (uint32_t i = 1; i <= tree->count && ok; i++) {
+        uint32_t left = tree->nodes[i].left & COMPACT_INDEX_MASK, right = tree->nodes[i].right;
+        //a link is only marked once it is known to point into the image
+        if (left != COMPACT_NIL) {
+            ok = left == i + 1 && left <= tree->count && !hasParent[left];
+            if (ok) {
+                hasParent[left] = 1;
+            }
+        }
+        if (ok && right != COMPACT_NIL) {
+            ok = right > i && right <= tree->count && !hasParent[right];
+            if (ok) {
+                hasParent[right] = 1;
+            }
+        }
+    }
+    for (uint32_t i = 2; i <= tree->count && ok; i++) {
+        ok = hasParent[i];
+    }
+    free(hasParent);
+    if (!ok) {
+        fprintf(stderr, "Error: the tree image is damaged.\n");
+    }
+    return ok;
+}
+
+//in pre-order every child comes after its parent, so walking the image backwards
+//finds both children of a node already built; built[] maps image indices to the new nodes
+AVLNode* rebuildAVL(const TreeImage* image)
+{
+    const CompactTree* tree = &image->tree;
+    if (image->kind != IMAGE_AVL) {
+        fprintf(stderr, "Error: only an AVL image can be rebuilt into an AVL tree.\n");
+        return NULL;
+    }
+    if (tree->count == 0 || !checkImage(tree)) {
+        return NULL;
+    }
+    AVLNode** built = (AVLNode**)malloc(sizeof(AVLNode*) * ((size_t)tree->count + 1));
+    if (built == NULL) {
+        return NULL;
+    }
+    built[COMPACT_NIL] = NULL;
+    for (uint32_t i = tree->count; i >= 1; i--) {
+        const CompactNode* node = &tree->nodes[i];
+        AVLNode* copy = allocAVLNode(node->val);
+        copy->left = built[node->left & COMPACT_INDEX_MASK];
+        copy->right = built[node->right];
+        updateAVL(copy);
+        built[i] = copy;
+    }
+    AVLNode* root = built[1];
+    free(built);
+    return root;
+}
+
+BSTNode* rebuildBST(const TreeImage* image)
+{
+    const CompactTree* tree = &image->tree;
+    if (tree->count == 0 || !checkImage(tree)) {
+        return NULL;
+    }
+    BSTNode** built = (BSTNode**)malloc(sizeof(BSTNode*) * ((size_t)tree->count + 1));
+    if (built == NULL) {
+        return NULL;
+    }
+    built[COMPACT_NIL] = NULL;
+    for (uint32_t i = tree->count; i >= 1; i--) {
+        const CompactNode* node = &tree->nodes[i];
+        BSTNode* copy = allocBSTNode(node->val);
+        copy->left = built[node->left & COMPACT_INDEX_MASK];
+        copy->right = built[node->right];
+        built[i] = copy;
+    }
+    BSTNode* root = built[1];
+    free(built);
+    return root;
+}
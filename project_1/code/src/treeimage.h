@@ -0,0 +1,37 @@
+#ifndef TREEIMAGE_HEADER
+#define TREEIMAGE_HEADER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "AVLTree.h"
+#include "BST.h"
+#include "compact.h"
+
+//a tree saved to disk as the node array of compact.h, in pre-order with the root at index 1
+//a 32-byte header comes first, then the nodes [0, count]; node 0 is the unused "no child" slot
+//the AVL balance factors are kept in the top bits of left as in compact.h, the heights and sizes are recomputed on rebuild
+//the nodes are stored in host byte order, an image written on a machine of the other byte order is refused
+//
+//restarting from an image never inserts a key:
+//  mapTreeImage(): O(1), the mapped nodes are searched in place with compactSearch()
+//  rebuildAVL() / rebuildBST(): O(n), the pointer-based tree is rebuilt bottom-up without a single rotation
+
+#define IMAGE_BST 0
+#define IMAGE_AVL 1
+
+typedef struct TreeImage {
+    CompactTree tree;     //nodes point into the mapping, so the tree is read-only
+    int kind;             //IMAGE_BST or IMAGE_AVL
+    void* mapping;
+    size_t mappingBytes;
+} TreeImage;
+
+int saveAVLImage(AVLNode* root, const char* path);   //1 on success, prints the reason to stderr on failure
+int saveBSTImage(BSTNode* root, const char* path);
+int mapTreeImage(TreeImage* image, const char* path);  //1 on success
+void unmapTreeImage(TreeImage* image);
+
+AVLNode* rebuildAVL(const TreeImage* image);  //NULL for an empty image or if there is not enough memory
+BSTNode* rebuildBST(const TreeImage* image);
+
+#endif
@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <string.h>
+#include "treestats.h"
+
+#ifdef TREE_STATS
+
+TreeStats treeStats;
+
+void statsReset(void)
+{
+    memset(&treeStats, 0, sizeof(treeStats));
+}
+
+void statsReport(const char* name, int n, const char* order_type)
+{
+    FILE* file = fopen("test_data/stats_results.csv", "a");
+    if (file == NULL) {
+        perror("Failed to open test_data/stats_results.csv");
+        return;
+    }
+    double ops = treeStats.operations ? (double)treeStats.operations : 1.0;
+    double splays = treeStats.splays ? (double)treeStats.splays : 1.0;
+    if (ftell(file) == 0) {
+        fprintf(file, "tree,n,order,operations,rot_ll,rot_lr,rot_rr,rot_rl,zig,zig_zig,zig_zag,"
+                      "comparisons_per_op,depth_avg,depth_max,splay_path_avg,splay_path_max\n");
+    }
+    fprintf(file, "%s,%d,%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%f,%f,%llu,%f,%llu\n",
+            name, n, order_type, treeStats.operations,
+            treeStats.rotLL, treeStats.rotLR, treeStats.rotRR, treeStats.rotRL,
+            treeStats.zig, treeStats.zigZig, treeStats.zigZag,
+            treeStats.comparisons / ops, treeStats.depthSum / ops, treeStats.depthMax,
+            treeStats.splayPathSum / splays, treeStats.splayPathMax);
+    fclose(file);
+    printf("Stats of %s with N=%d (%s): rotations LL %llu LR %llu RR %llu RL %llu, zig %llu zig-zig %llu zig-zag %llu\n",
+           name, n, order_type, treeStats.rotLL, treeStats.rotLR, treeStats.rotRR, treeStats.rotRL,
+           treeStats.zig, treeStats.zigZig, treeStats.zigZag);
+    printf("    %.2f comparisons per op, depth avg %.2f max %llu, splay path avg %.2f max %llu\n",
+           treeStats.comparisons / ops, treeStats.depthSum / ops, treeStats.depthMax,
+           treeStats.splayPathSum / splays, treeStats.splayPathMax);
+}
+
+#endif
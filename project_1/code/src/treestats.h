@@ -0,0 +1,64 @@
+#ifndef TREESTATS_HEADER
+#define TREESTATS_HEADER
+
+#include <stdio.h>
+
+//compile-time instrumentation of the AVL and splay trees, switched on with -DTREE_STATS (cmake -DTREE_STATS=ON)
+//without it every macro below expands to the bare expression or to nothing, so the trees run exactly as before
+//
+//the counters are global: tree_analyzer resets them before a tree, marks every operation with
+//STATS_OP_BEGIN()/STATS_OP_END() and prints them with STATS_REPORT() afterwards
+
+#ifdef TREE_STATS
+
+typedef struct TreeStats {
+    unsigned long long rotLL, rotLR, rotRR, rotRL;   //AVL rebalancing cases
+    unsigned long long zig, zigZig, zigZag;          //splay steps
+    unsigned long long comparisons;                  //key comparisons
+    unsigned long long operations;
+    unsigned long long depth;                        //nodes visited by the current operation
+    unsigned long long depthSum, depthMax;
+    unsigned long long splays;
+    unsigned long long splayPath;                    //edges the node being splayed has climbed so far
+    unsigned long long splayPathSum, splayPathMax;
+} TreeStats;
+
+extern TreeStats treeStats;
+
+void statsReset(void);
+void statsReport(const char* name, int n, const char* order_type);   //console and test_data/stats_results.csv
+
+#define STATS_COUNT(field) (treeStats.field++)
+#define STATS_VISIT() (treeStats.depth++)
+#define STATS_LT(a, b) (treeStats.comparisons++, (a) < (b))
+#define STATS_GT(a, b) (treeStats.comparisons++, (a) > (b))
+#define STATS_EQ(a, b) (treeStats.comparisons++, (a) == (b))
+#define STATS_SPLAY_STEP(field, edges) (treeStats.field++, treeStats.splayPath += (edges))
+#define STATS_SPLAY_END() \
+    (treeStats.splays++, treeStats.splayPathSum += treeStats.splayPath, \
+     treeStats.splayPathMax = treeStats.splayPath > treeStats.splayPathMax ? treeStats.splayPath : treeStats.splayPathMax, \
+     treeStats.splayPath = 0)
+#define STATS_OP_BEGIN() (treeStats.depth = 0)
+#define STATS_OP_END() \
+    (treeStats.operations++, treeStats.depthSum += treeStats.depth, \
+     treeStats.depthMax = treeStats.depth > treeStats.depthMax ? treeStats.depth : treeStats.depthMax)
+#define STATS_RESET() statsReset()
+#define STATS_REPORT(name, n, order_type) statsReport(name, n, order_type)
+
+#else
+
+#define STATS_COUNT(field) ((void)0)
+#define STATS_VISIT() ((void)0)
+#define STATS_LT(a, b) ((a) < (b))
+#define STATS_GT(a, b) ((a) > (b))
+#define STATS_EQ(a, b) ((a) == (b))
+#define STATS_SPLAY_STEP(field, edges) ((void)0)
+#define STATS_SPLAY_END() ((void)0)
+#define STATS_OP_BEGIN() ((void)0)
+#define STATS_OP_END() ((void)0)
+#define STATS_RESET() ((void)0)
+#define STATS_REPORT(name, n, order_type) ((void)0)
+
+#endif
+
+#endif
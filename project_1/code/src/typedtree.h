@@ -0,0 +1,318 @@
+#ifndef TYPEDTREE_HEADER
+#define TYPEDTREE_HEADER
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// BST, AVL and top-down splay trees generated for one key type and comparator at compile time
+// DEFINE_TYPED_TREES(Prefix, KeyType, compare) expands to static node types and functions named
+// Prefix##BSTNode, Prefix##InsertBST, Prefix##AVLNode, Prefix##DeleteAVL, Prefix##SplaySearch, ...
+// compare(a, b) returns <0, 0 or >0 like strcmp, and is inlined into every tree
+// the trees keep the keys by value, so a string key must outlive the tree it is in
+// the int trees in BST.c / AVLTree.c / splay.c stay the int API, with their pools, engines and counters
+
+static inline int compareInt32(int32_t a, int32_t b) {
+    return (a > b) - (a < b);
+}
+
+static inline int compareInt64(int64_t a, int64_t b) {
+    return (a > b) - (a < b);
+}
+
+static inline int compareString(const char* a, const char* b) {
+    return strcmp(a, b);
+}
+
+// A string key with its first 8 bytes cached in the node as one big-endian integer,
+// so most comparisons are a single integer compare and never touch the string itself
+typedef struct StrKey {
+    uint64_t prefix;   // the first 8 bytes, padded with zeros
+    const char* str;
+} StrKey;
+
+static inline StrKey makeStrKey(const char* str) {
+    StrKey key;
+    uint64_t prefix = 0;
+    int i = 0;
+    for (; i < 8 && str[i] != '\0'; i++) prefix = (prefix << 8) | (unsigned char)str[i];
+    for (; i < 8; i++) prefix <<= 8;
+    key.prefix = prefix;
+    key.str = str;
+    return key;
+}
+
+static inline int compareStrKey(StrKey a, StrKey b) {
+    if (a.prefix != b.prefix) return a.prefix < b.prefix ? -1 : 1;
+    if ((a.prefix & 0xff) == 0) return 0;   // both strings end inside the prefix, so they are equal
+    return strcmp(a.str + 8, b.str + 8);
+}
+
+#define DEFINE_TYPED_BST(P, KEY, CMP)                                               \
+typedef struct P##BSTNode {                                                         \
+    KEY key;                                                                        \
+    struct P##BSTNode* left;                                                        \
+    struct P##BSTNode* right;                                                       \
+} P##BSTNode;                                                                       \
+                                                                                    \
+static P##BSTNode* P##InsertBST(P##BSTNode* root, KEY key) {                        \
+    P##BSTNode** link = &root;                                                      \
+    while (*link != NULL) {                                                         \
+        int c = CMP(key, (*link)->key);                                             \
+        if (c == 0) return root;   /* a duplicated key is ignored */                \
+        link = c < 0 ? &(*link)->left : &(*link)->right;                            \
+    }                                                                               \
+    P##BSTNode* node = (P##BSTNode*)malloc(sizeof(P##BSTNode));                     \
+    node->key = key;                                                                \
+    node->left = node->right = NULL;                                                \
+    *link = node;                                                                   \
+    return root;                                                                    \
+}                                                                                   \
+                                                                                    \
+static P##BSTNode* P##DeleteBST(P##BSTNode* root, KEY key) {                        \
+    P##BSTNode** link = &root;                                                      \
+    while (*link != NULL) {                                                         \
+        int c = CMP(key, (*link)->key);                                             \
+        if (c == 0) break;                                                          \
+        link = c < 0 ? &(*link)->left : &(*link)->right;                            \
+    }                                                                               \
+    P##BSTNode* node = *link;                                                       \
+    if (node == NULL) return root;                                                  \
+    if (node->left != NULL && node->right != NULL) {                                \
+        /* take over the key of the successor and unlink the successor instead */   \
+        P##BSTNode** minLink = &node->right;                                        \
+        while ((*minLink)->left != NULL) minLink = &(*minLink)->left;               \
+        P##BSTNode* min = *minLink;                                                 \
+        node->key = min->key;                                                       \
+        *minLink = min->right;                                                      \
+        free(min);                                                                  \
+    } else {                                                                        \
+        *link = node->left != NULL ? node->left : node->right;                      \
+        free(node);                                                                 \
+    }                                                                               \
+    return root;                                                                    \
+}                                                                                   \
+                                                                                    \
+static P##BSTNode* P##SearchBST(P##BSTNode* root, KEY key) {                        \
+    while (root != NULL) {                                                          \
+        int c = CMP(key, root->key);                                                \
+        if (c == 0) return root;                                                    \
+        root = c < 0 ? root->left : root->right;                                    \
+    }                                                                               \
+    return NULL;                                                                    \
+}                                                                                   \
+                                                                                    \
+static void P##FreeBST(P##BSTNode* root) {                                          \
+    if (root == NULL) return;                                                       \
+    P##FreeBST(root->left);                                                         \
+    P##FreeBST(root->right);                                                        \
+    free(root);                                                                     \
+}
+
+#define DEFINE_TYPED_AVL(P, KEY, CMP)                                               \
+typedef struct P##AVLNode {                                                         \
+    KEY key;                                                                        \
+    int height;                                                                     \
+    struct P##AVLNode* left;                                                        \
+    struct P##AVLNode* right;                                                       \
+} P##AVLNode;                                                                       \
+                                                                                    \
+static int P##HeightAVL(P##AVLNode* node) {                                         \
+    return node != NULL ? node->height : 0;                                         \
+}                                                                                   \
+                                                                                    \
+static void P##UpdateAVL(P##AVLNode* node) {                                        \
+    int hl = P##HeightAVL(node->left), hr = P##HeightAVL(node->right);              \
+    node->height = 1 + (hl > hr ? hl : hr);                                         \
+}                                                                                   \
+                                                                                    \
+static P##AVLNode* P##RotateRightAVL(P##AVLNode* node) {                            \
+    P##AVLNode* left = node->left;                                                  \
+    node->left = left->right;                                                       \
+    left->right = node;                                                             \
+    P##UpdateAVL(node);                                                             \
+    P##UpdateAVL(left);                                                             \
+    return left;                                                                    \
+}                                                                                   \
+                                                                                    \
+static P##AVLNode* P##RotateLeftAVL(P##AVLNode* node) {                             \
+    P##AVLNode* right = node->right;                                                \
+    node->right = right->left;                                                      \
+    right->left = node;                                                             \
+    P##UpdateAVL(node);                                                             \
+    P##UpdateAVL(right);                                                            \
+    return right;                                                                   \
+}                                                                                   \
+                                                                                    \
+static P##AVLNode* P##RebalanceAVL(P##AVLNode* node) {                              \
+    P##UpdateAVL(node);                                                             \
+    int balance = P##HeightAVL(node->left) - P##HeightAVL(node->right);             \
+    if (balance > 1) {                                                              \
+        if (P##HeightAVL(node->left->left) < P##HeightAVL(node->left->right))       \
+            node->left = P##RotateLeftAVL(node->left);   /* LR */                   \
+        return P##RotateRightAVL(node);                                             \
+    }                                                                               \
+    if (balance < -1) {                                                             \
+        if (P##HeightAVL(node->right->right) < P##HeightAVL(node->right->left))     \
+            node->right = P##RotateRightAVL(node->right);   /* RL */                \
+        return P##RotateLeftAVL(node);                                              \
+    }                                                                               \
+    return node;                                                                    \
+}                                                                                   \
+                                                                                    \
+static P##AVLNode* P##InsertAVL(P##AVLNode* node, KEY key) {                        \
+    if (node == NULL) {                                                             \
+        node = (P##AVLNode*)malloc(sizeof(P##AVLNode));                             \
+        node->key = key;                                                            \
+        node->height = 1;                                                           \
+        node->left = node->right = NULL;                                            \
+        return node;                                                                \
+    }                                                                               \
+    int c = CMP(key, node->key);                                                    \
+    if (c == 0) return node;   /* a duplicated key is ignored */                    \
+    if (c < 0) node->left = P##InsertAVL(node->left, key);                          \
+    else node->right = P##InsertAVL(node->right, key);                              \
+    return P##RebalanceAVL(node);                                                   \
+}                                                                                   \
+                                                                                    \
+static P##AVLNode* P##DeleteAVL(P##AVLNode* node, KEY key) {                        \
+    if (node == NULL) return NULL;                                                  \
+    int c = CMP(key, node->key);                                                    \
+    if (c < 0) {                                                                    \
+        node->left = P##DeleteAVL(node->left, key);                                 \
+    } else if (c > 0) {                                                             \
+        node->right = P##DeleteAVL(node->right, key);                               \
+    } else if (node->left == NULL || node->right == NULL) {                         \
+        P##AVLNode* child = node->left != NULL ? node->left : node->right;          \
+        free(node);                                                                 \
+        return child;                                                               \
+    } else {                                                                        \
+        P##AVLNode* min = node->right;                                              \
+        while (min->left != NULL) min = min->left;                                  \
+        node->key = min->key;                                                       \
+        node->right = P##DeleteAVL(node->right, min->key);                          \
+    }                                                                               \
+    return P##RebalanceAVL(node);                                                   \
+}                                                                                   \
+                                                                                    \
+static P##AVLNode* P##SearchAVL(P##AVLNode* root, KEY key) {                        \
+    while (root != NULL) {                                                          \
+        int c = CMP(key, root->key);                                                \
+        if (c == 0) return root;                                                    \
+        root = c < 0 ? root->left : root->right;                                    \
+    }                                                                               \
+    return NULL;                                                                    \
+}                                                                                   \
+                                                                                    \
+static void P##FreeAVL(P##AVLNode* root) {                                          \
+    if (root == NULL) return;                                                       \
+    P##FreeAVL(root->left);                                                         \
+    P##FreeAVL(root->right);                                                        \
+    free(root);                                                                     \
+}
+
+// The splay tree is the top-down one of splayTD.c, it needs no parent pointers
+#define DEFINE_TYPED_SPLAY(P, KEY, CMP)                                             \
+typedef struct P##SplayNode {                                                       \
+    KEY key;                                                                        \
+    struct P##SplayNode* left;                                                      \
+    struct P##SplayNode* right;                                                     \
+} P##SplayNode;                                                                     \
+                                                                                    \
+static P##SplayNode* P##Splay(P##SplayNode* root, KEY key) {                        \
+    if (root == NULL) return NULL;                                                  \
+    P##SplayNode header;   /* .right collects the left tree, .left the right tree */\
+    P##SplayNode *l = &header, *r = &header, *y;                                    \
+    header.left = header.right = NULL;                                              \
+    for (;;) {                                                                      \
+        int c = CMP(key, root->key);                                                \
+        if (c < 0) {                                                                \
+            if (root->left == NULL) break;                                          \
+            if (CMP(key, root->left->key) < 0) {   /* zig-zig: rotate right */      \
+                y = root->left;                                                     \
+                root->left = y->right;                                              \
+                y->right = root;                                                    \
+                root = y;                                                           \
+                if (root->left == NULL) break;                                      \
+            }                                                                       \
+            r->left = root;                                                         \
+            r = root;                                                               \
+            root = root->left;                                                      \
+        } else if (c > 0) {                                                         \
+            if (root->right == NULL) break;                                         \
+            if (CMP(key, root->right->key) > 0) {   /* zig-zig: rotate left */      \
+                y = root->right;                                                    \
+                root->right = y->left;                                              \
+                y->left = root;                                                     \
+                root = y;                                                           \
+                if (root->right == NULL) break;                                     \
+            }                                                                       \
+            l->right = root;                                                        \
+            l = root;                                                               \
+            root = root->right;                                                     \
+        } else {                                                                    \
+            break;                                                                  \
+        }                                                                           \
+    }                                                                               \
+    l->right = root->left;                                                          \
+    r->left = root->right;                                                          \
+    root->left = header.right;                                                      \
+    root->right = header.left;                                                      \
+    return root;                                                                    \
+}                                                                                   \
+                                                                                    \
+static P##SplayNode* P##InsertSplay(P##SplayNode* root, KEY key) {                  \
+    root = P##Splay(root, key);                                                     \
+    int c = root != NULL ? CMP(key, root->key) : 0;                                 \
+    if (root != NULL && c == 0) return root;   /* a duplicated key is ignored */    \
+    P##SplayNode* node = (P##SplayNode*)malloc(sizeof(P##SplayNode));               \
+    node->key = key;                                                                \
+    if (root == NULL) {                                                             \
+        node->left = node->right = NULL;                                            \
+    } else if (c < 0) {                                                             \
+        node->left = root->left;                                                    \
+        node->right = root;                                                         \
+        root->left = NULL;                                                          \
+    } else {                                                                        \
+        node->right = root->right;                                                  \
+        node->left = root;                                                          \
+        root->right = NULL;                                                         \
+    }                                                                               \
+    return node;                                                                    \
+}                                                                                   \
+                                                                                    \
+static P##SplayNode* P##DeleteSplay(P##SplayNode* root, KEY key) {                  \
+    root = P##Splay(root, key);                                                     \
+    if (root == NULL || CMP(key, root->key) != 0) return root;                      \
+    P##SplayNode* rest;                                                             \
+    if (root->left == NULL) {                                                       \
+        rest = root->right;                                                         \
+    } else {                                                                        \
+        /* splaying the left tree brings its maximum up, which has no right child */\
+        rest = P##Splay(root->left, key);                                           \
+        rest->right = root->right;                                                  \
+    }                                                                               \
+    free(root);                                                                     \
+    return rest;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* returns the new root, *found is 1 if the key is at the root */                   \
+static P##SplayNode* P##SearchSplay(P##SplayNode* root, KEY key, int* found) {      \
+    root = P##Splay(root, key);                                                     \
+    *found = root != NULL && CMP(key, root->key) == 0;                              \
+    return root;                                                                    \
+}                                                                                   \
+                                                                                    \
+static void P##FreeSplay(P##SplayNode* root) {                                      \
+    if (root == NULL) return;                                                       \
+    P##FreeSplay(root->left);                                                       \
+    P##FreeSplay(root->right);                                                      \
+    free(root);                                                                     \
+}
+
+#define DEFINE_TYPED_TREES(P, KEY, CMP) \
+    DEFINE_TYPED_BST(P, KEY, CMP)       \
+    DEFINE_TYPED_AVL(P, KEY, CMP)       \
+    DEFINE_TYPED_SPLAY(P, KEY, CMP)
+
+#endif
@@ -0,0 +1,313 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include "workload.h"
+
+#define WORKLOAD_SEED 0x2025ADULL
+//fixed, so that two runs of tree_analyzer see the same operations
+
+static uint64_t rngState;
+
+static uint64_t nextRandom(void)
+{
+    //xorshift64*: fast and good enough to pick keys, rand() is too coarse for big n
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545F4914F6CDD1DULL;
+}
+
+static double nextUniform(void)
+{
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+    //53 random bits, in [0, 1)
+}
+
+static int nextBelow(int bound)
+{
+    return (int)(nextUniform() * bound);
+}
+
+int parseMix(const char* text, WorkloadMix* mix)
+{
+    char tail;
+    if (sscanf(text, "%d/%d/%d%c", &mix->read, &mix->insert, &mix->remove, &tail) != 3) {
+        return 0;
+    }
+    if (mix->read < 0 || mix->insert < 0 || mix->remove < 0 || mix->read + mix->insert + mix->remove == 0) {
+        return 0;
+    }
+    snprintf(mix->name, sizeof(mix->name), "%d/%d/%d", mix->read, mix->insert, mix->remove);
+    return 1;
+}
+
+int parseDistribution(const char* text, KeyDistribution* dist)
+{
+    char tail;
+    int fields;
+    if (strcmp(text, "uniform") == 0) {
+        dist->kind = DIST_UNIFORM;
+        snprintf(dist->name, sizeof(dist->name), "uniform");
+        return 1;
+    }
+    if (strncmp(text, "zipf", 4) == 0) {
+        dist->kind = DIST_ZIPF;
+        dist->param1 = 0.99;
+        //the skew YCSB uses by default
+        if (text[4] != '\0' && (text[4] != ':' || sscanf(text + 5, "%lf%c", &dist->param1, &tail) != 1)) {
+            return 0;
+        }
+        if (dist->param1 <= 0) {
+            return 0;
+        }
+        snprintf(dist->name, sizeof(dist->name), "zipf:%g", dist->param1);
+        return 1;
+    }
+    if (strncmp(text, "hot", 3) == 0) {
+        dist->kind = DIST_HOTSET;
+        dist->param1 = 0.1;
+        dist->param2 = 0.9;
+        //10% of the keys get 90% of the operations
+        if (text[3] != '\0') {
+            fields = text[3] == ':' ? sscanf(text + 4, "%lf:%lf%c", &dist->param1, &dist->param2, &tail) : 0;
+            if (fields != 2) {
+                return 0;
+            }
+        }
+        if (dist->param1 <= 0 || dist->param1 > 1 || dist->param2 < 0 || dist->param2 > 1) {
+            return 0;
+        }
+        snprintf(dist->name, sizeof(dist->name), "hot:%g:%g", dist->param1, dist->param2);
+        return 1;
+    }
+    if (strncmp(text, "sliding", 7) == 0) {
+        dist->kind = DIST_SLIDING;
+        dist->param1 = 0.1;
+        if (text[7] != '\0' && (text[7] != ':' || sscanf(text + 8, "%lf%c", &dist->param1, &tail) != 1)) {
+            return 0;
+        }
+        if (dist->param1 <= 0 || dist->param1 > 1) {
+            return 0;
+        }
+        snprintf(dist->name, sizeof(dist->name), "sliding:%g", dist->param1);
+        return 1;
+    }
+    return 0;
+}
+
+static double* zipfTable(int n, double s)
+{
+    //cdf[r] = P(rank <= r), a rank is drawn with a binary search over it
+    double* cdf = (double*)malloc(sizeof(double) * n);
+    if (cdf == NULL) {
+        return NULL;
+    }
+    double sum = 0;
+    for (int r = 0; r < n; r++) {
+        sum += 1.0 / pow(r + 1, s);
+        cdf[r] = sum;
+    }
+    for (int r = 0; r < n; r++) {
+        cdf[r] /= sum;
+    }
+    return cdf;
+}
+
+static int nextRank(const KeyDistribution* dist, const double* cdf, int n, int op, int ops)
+{
+    if (dist->kind == DIST_ZIPF) {
+        double u = nextUniform();
+        int lo = 0, hi = n - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (cdf[mid] < u) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+    if (dist->kind == DIST_HOTSET) {
+        int hot = (int)(dist->param1 * n);
+        if (hot < 1) hot = 1;
+        if (hot == n || nextUniform() < dist->param2) {
+            return nextBelow(hot);
+        }
+        return hot + nextBelow(n - hot);
+    }
+    if (dist->kind == DIST_SLIDING) {
+        int window = (int)(dist->param1 * n);
+        if (window < 1) window = 1;
+        int first = (int)((long long)op * n / ops);
+        return (first + nextBelow(window)) % n;
+    }
+    return nextBelow(n);
+}
+
+//the popularity ranks whose key is in one state (in the tree or not): a bitset with a summary bitset above it per
+//level, bit i of a level telling whether word i of the level below has any bit set, so the next rank in the set is
+//found and a rank is moved in or out with one word per level, ceil(log64 n) of them
+#define RANK_MAX_LEVELS 6   //64^6 bits cover every int
+typedef struct RankSet {
+    uint64_t* bits[RANK_MAX_LEVELS];
+    size_t words[RANK_MAX_LEVELS];
+    int levels;
+} RankSet;
+
+static int rankSetInit(RankSet* set, int n)
+{
+    memset(set, 0, sizeof(*set));
+    size_t bitCount = (size_t)n;
+    do {
+        size_t words = (bitCount + 63) / 64;
+        set->bits[set->levels] = (uint64_t*)calloc(words, sizeof(uint64_t));
+        set->words[set->levels] = words;
+        if (set->bits[set->levels++] == NULL) {
+            return 0;
+        }
+        bitCount = words;
+    } while (bitCount > 1);
+    return 1;
+}
+
+static void rankSetFree(RankSet* set)
+{
+    for (int l = 0; l < set->levels; l++) {
+        free(set->bits[l]);
+    }
+}
+
+static void rankSetAdd(RankSet* set, size_t rank)
+{
+    for (int l = 0; l < set->levels; l++) {
+        uint64_t before = set->bits[l][rank / 64];
+        set->bits[l][rank / 64] = before | 1ULL << (rank % 64);
+        if (before != 0) {
+            break;
+        }
+        //the word was empty, so the level above does not know about it yet
+        rank /= 64;
+    }
+}
+
+static void rankSetRemove(RankSet* set, size_t rank)
+{
+    for (int l = 0; l < set->levels; l++) {
+        set->bits[l][rank / 64] &= ~(1ULL << (rank % 64));
+        if (set->bits[l][rank / 64] != 0) {
+            break;
+        }
+        rank /= 64;
+    }
+}
+
+static long long rankSetNext(const RankSet* set, size_t rank)
+{
+    //the smallest rank >= rank in the set, -1 if there is none: climb until a word holds a bit at or after the
+    //position, then descend along the lowest set bits
+    int l = 0;
+    size_t pos = rank;
+    while (1) {
+        if (l == set->levels) {
+            return -1;
+        }
+        size_t w = pos / 64;
+        if (w < set->words[l]) {
+            uint64_t x = set->bits[l][w] & (~0ULL << (pos % 64));
+            if (x != 0) {
+                pos = w * 64 + (size_t)__builtin_ctzll(x);
+                break;
+            }
+        }
+        pos = w + 1;
+        l++;
+    }
+    while (l > 0) {
+        l--;
+        pos = pos * 64 + (size_t)__builtin_ctzll(set->bits[l][pos]);
+    }
+    return (long long)pos;
+}
+
+int makeWorkload(Workload* work, const int* values, int n, const WorkloadMix* mix, const KeyDistribution* dist, int ops)
+{
+    int* position = (int*)malloc(sizeof(int) * n);     //popularity rank -> position in the data set
+    char* present = (char*)malloc(n);                  //is the key at this position in the tree
+    double* cdf = dist->kind == DIST_ZIPF ? zipfTable(n, dist->param1) : NULL;
+    RankSet sets[2];                                   //sets[1]: the ranks of the keys in the tree, sets[0]: the others
+    int setsReady = rankSetInit(&sets[0], n) & rankSetInit(&sets[1], n);
+    work->ops = (WorkloadOp*)malloc(sizeof(WorkloadOp) * ops);
+    work->preload = (int*)malloc(sizeof(int) * (n / 2 + 1));
+    if (position == NULL || present == NULL || !setsReady || work->ops == NULL || work->preload == NULL
+        || (dist->kind == DIST_ZIPF && cdf == NULL)) {
+        free(position);
+        free(present);
+        free(cdf);
+        rankSetFree(&sets[0]);
+        rankSetFree(&sets[1]);
+        freeWorkload(work);
+        return 0;
+    }
+
+    rngState = WORKLOAD_SEED;
+    for (int r = 0; r < n; r++) {
+        position[r] = r;
+    }
+    for (int r = n - 1; r > 0; r--) {
+        int j = nextBelow(r + 1);
+        int temp = position[r];
+        position[r] = position[j];
+        position[j] = temp;
+    }
+    //the popular keys are spread over the whole key range instead of sitting at one end of it
+
+    work->preloadCount = 0;
+    for (int i = 0; i < n; i++) {
+        present[i] = i % 2 == 0;
+        if (present[i]) {
+            work->preload[work->preloadCount++] = values[i];
+        }
+    }
+    int presentCount = work->preloadCount;
+    for (int r = 0; r < n; r++) {
+        rankSetAdd(&sets[present[position[r]] != 0], (size_t)r);
+    }
+
+    int total = mix->read + mix->insert + mix->remove;
+    for (int op = 0; op < ops; op++) {
+        int pick = nextBelow(total);
+        int type = pick < mix->read ? OP_READ : (pick < mix->read + mix->insert ? OP_INSERT : OP_DELETE);
+        int rank = nextRank(dist, cdf, n, op, ops);
+        if ((type == OP_INSERT && presentCount == n) || (type == OP_DELETE && presentCount == 0)) {
+            type = OP_READ;
+        } else if (type != OP_READ) {
+            //the next rank with a key in the right state, wrapping around after the last rank
+            RankSet* from = &sets[type == OP_DELETE];
+            long long next = rankSetNext(from, (size_t)rank);
+            rank = (int)(next >= 0 ? next : rankSetNext(from, 0));
+            rankSetRemove(from, (size_t)rank);
+            rankSetAdd(&sets[type == OP_INSERT], (size_t)rank);
+            presentCount += type == OP_INSERT ? 1 : -1;
+        }
+        work->ops[op].type = type;
+        work->ops[op].key = values[position[rank]];
+    }
+    work->count = ops;
+
+    free(position);
+    free(present);
+    free(cdf);
+    rankSetFree(&sets[0]);
+    rankSetFree(&sets[1]);
+    return 1;
+}
+
+void freeWorkload(Workload* work)
+{
+    free(work->ops);
+    free(work->preload);
+    work->ops = NULL;
+    work->preload = NULL;
+    work->count = 0;
+    work->preloadCount = 0;
+}
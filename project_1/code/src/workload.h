@@ -0,0 +1,58 @@
+#ifndef WORKLOAD_HEADER
+#define WORKLOAD_HEADER
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//mixed read/insert/delete workloads with skewed keys, for --workload
+//the whole operation stream is generated up front, so every tree runs exactly the same operations
+//and the timed loop does nothing but call the tree
+//
+//the key universe is the data set: a key's popularity rank is given by a fixed shuffle of the data set,
+//and the keys at even positions of the data set are in the tree before the first operation
+
+#define OP_READ 0
+#define OP_INSERT 1
+#define OP_DELETE 2
+
+#define DIST_UNIFORM 0
+#define DIST_ZIPF 1      //rank r is picked with probability ~ 1 / (r + 1)^s
+#define DIST_HOTSET 2    //a fraction of the keys gets a fraction of the operations
+#define DIST_SLIDING 3   //uniform over a window of keys that moves through the whole key space once
+
+typedef struct WorkloadMix {
+    int read, insert, remove;   //relative weights, e.g. 95/5/0
+    char name[36];              //room for three ints and the slashes
+} WorkloadMix;
+
+typedef struct KeyDistribution {
+    int kind;
+    double param1;   //zipf: s, hot set: fraction of the keys, sliding: window size as a fraction of the keys
+    double param2;   //hot set: fraction of the operations that go to the hot keys
+    char name[48];
+} KeyDistribution;
+
+typedef struct WorkloadOp {
+    int type;
+    int key;
+} WorkloadOp;
+
+typedef struct Workload {
+    WorkloadOp* ops;
+    int count;
+    int* preload;      //the keys to insert before the timed run, in data set order
+    int preloadCount;
+} Workload;
+
+int parseMix(const char* text, WorkloadMix* mix);
+//"95/5/0", returns 0 if text is malformed
+int parseDistribution(const char* text, KeyDistribution* dist);
+//"uniform", "zipf[:s]", "hot[:keys:ops]" or "sliding[:window]", returns 0 if text is malformed
+
+int makeWorkload(Workload* work, const int* values, int n, const WorkloadMix* mix, const KeyDistribution* dist, int ops);
+//returns 0 if there is not enough memory
+//an insert always gets a key that is not in the tree and a delete one that is,
+//the next key in popularity order is taken instead if needed, and a read is issued if there is none
+void freeWorkload(Workload* work);
+
+#endif